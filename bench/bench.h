@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2022  Martin Lund
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <glib.h>
+#include <math.h>
+
+#define BENCH_WIDTH 1920
+#define BENCH_HEIGHT 1080
+
+// Fill x/y with a noisy sine sweep across the bench surface
+static inline void bench_generate(double *x, double *y, size_t n)
+{
+    GRand *rand = g_rand_new_with_seed(42);
+
+    for (size_t i = 0; i < n; i++)
+    {
+        x[i] = (double) i * BENCH_WIDTH / n;
+        y[i] = BENCH_HEIGHT / 2 + 0.4 * BENCH_HEIGHT * sin(i * 20.0 * G_PI / n) +
+               g_rand_double_range(rand, -20, 20);
+    }
+
+    g_rand_free(rand);
+}
+
+// Milliseconds elapsed since start (from g_get_monotonic_time())
+static inline double bench_ms(gint64 start)
+{
+    return (g_get_monotonic_time() - start) / 1000.0;
+}
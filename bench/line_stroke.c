@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2022  Martin Lund
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Compare stroking a polyline one segment at a time against a single path
+
+#include <stdio.h>
+#include <cairo.h>
+#include "bench.h"
+
+static cairo_t * bench_cairo_new(cairo_surface_t *surface)
+{
+    cairo_t *cr = cairo_create(surface);
+
+    // Same settings as the line chart renderer
+    cairo_set_antialias(cr, CAIRO_ANTIALIAS_FAST);
+    cairo_set_tolerance(cr, 1.5);
+    cairo_set_line_width(cr, 2.0);
+    cairo_set_source_rgba(cr, 0.2, 0.4, 0.8, 1.0);
+
+    return cr;
+}
+
+static double stroke_per_segment(cairo_surface_t *surface, const double *x, const double *y, size_t n)
+{
+    cairo_t *cr = bench_cairo_new(surface);
+    gint64 start = g_get_monotonic_time();
+
+    cairo_move_to(cr, x[0], y[0]);
+    for (size_t i = 1; i < n; i++)
+    {
+        cairo_line_to(cr, x[i], y[i]);
+        cairo_set_line_join(cr, CAIRO_LINE_JOIN_ROUND);
+        cairo_stroke(cr);
+        cairo_move_to(cr, x[i], y[i]);
+    }
+    cairo_surface_flush(surface);
+
+    double ms = bench_ms(start);
+    cairo_destroy(cr);
+
+    return ms;
+}
+
+static double stroke_single_path(cairo_surface_t *surface, const double *x, const double *y, size_t n)
+{
+    cairo_t *cr = bench_cairo_new(surface);
+    gint64 start = g_get_monotonic_time();
+
+    cairo_move_to(cr, x[0], y[0]);
+    for (size_t i = 1; i < n; i++)
+    {
+        cairo_line_to(cr, x[i], y[i]);
+    }
+    cairo_set_line_join(cr, CAIRO_LINE_JOIN_ROUND);
+    cairo_stroke(cr);
+    cairo_surface_flush(surface);
+
+    double ms = bench_ms(start);
+    cairo_destroy(cr);
+
+    return ms;
+}
+
+int main(void)
+{
+    const size_t sizes[] = { 10000, 100000, 1000000 };
+    cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, BENCH_WIDTH, BENCH_HEIGHT);
+
+    printf("%10s %16s %16s %10s\n", "points", "per segment [ms]", "single path [ms]", "speedup");
+
+    for (size_t s = 0; s < G_N_ELEMENTS(sizes); s++)
+    {
+        size_t n = sizes[s];
+        double *x = g_new(double, n);
+        double *y = g_new(double, n);
+
+        bench_generate(x, y, n);
+
+        double segment_ms = stroke_per_segment(surface, x, y, n);
+        double path_ms = stroke_single_path(surface, x, y, n);
+
+        printf("%10zu %16.1f %16.1f %9.1fx\n", n, segment_ms, path_ms, segment_ms / path_ms);
+
+        g_free(x);
+        g_free(y);
+    }
+
+    cairo_surface_destroy(surface);
+
+    return 0;
+}
@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2022  Martin Lund
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Compare drawing scatter markers as paths against stamping a pre-rendered sprite
+
+#include <stdio.h>
+#include <cairo.h>
+#include "bench.h"
+
+#define MARKER_SIZE 3.0
+
+static cairo_t * bench_cairo_new(cairo_surface_t *surface)
+{
+    cairo_t *cr = cairo_create(surface);
+
+    // Same settings as the scatter chart renderer
+    cairo_set_antialias(cr, CAIRO_ANTIALIAS_FAST);
+    cairo_set_tolerance(cr, 1.5);
+    cairo_set_source_rgba(cr, 0.2, 0.4, 0.8, 1.0);
+
+    return cr;
+}
+
+// Zero length round capped stroke per point
+static double draw_per_point_stroke(cairo_surface_t *surface, const double *x, const double *y, size_t n)
+{
+    cairo_t *cr = bench_cairo_new(surface);
+    gint64 start = g_get_monotonic_time();
+
+    cairo_set_line_width(cr, MARKER_SIZE);
+    cairo_set_line_cap(cr, CAIRO_LINE_CAP_ROUND);
+    for (size_t i = 0; i < n; i++)
+    {
+        cairo_move_to(cr, x[i], y[i]);
+        cairo_line_to(cr, x[i], y[i]);
+        cairo_stroke(cr);
+    }
+    cairo_surface_flush(surface);
+
+    double ms = bench_ms(start);
+    cairo_destroy(cr);
+
+    return ms;
+}
+
+// All circles in one path, filled once
+static double draw_single_path(cairo_surface_t *surface, const double *x, const double *y, size_t n)
+{
+    cairo_t *cr = bench_cairo_new(surface);
+    gint64 start = g_get_monotonic_time();
+
+    for (size_t i = 0; i < n; i++)
+    {
+        cairo_new_sub_path(cr);
+        cairo_arc(cr, x[i], y[i], MARKER_SIZE / 2, 0, 2 * G_PI);
+    }
+    cairo_fill(cr);
+    cairo_surface_flush(surface);
+
+    double ms = bench_ms(start);
+    cairo_destroy(cr);
+
+    return ms;
+}
+
+static cairo_surface_t * sprite_new(double *extent)
+{
+    *extent = ceil(MARKER_SIZE) + 2;
+
+    cairo_surface_t *sprite = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, (int) *extent, (int) *extent);
+    cairo_t *cr = cairo_create(sprite);
+
+    cairo_set_source_rgba(cr, 0.2, 0.4, 0.8, 1.0);
+    cairo_arc(cr, *extent / 2, *extent / 2, MARKER_SIZE / 2, 0, 2 * G_PI);
+    cairo_fill(cr);
+    cairo_destroy(cr);
+
+    return sprite;
+}
+
+// Pre-rendered sprite stamped at pixel aligned positions, optionally once per pixel
+static double draw_sprite(cairo_surface_t *surface, const double *x, const double *y, size_t n, gboolean dedup)
+{
+    cairo_t *cr = bench_cairo_new(surface);
+    gint64 start = g_get_monotonic_time();
+    double extent;
+    cairo_surface_t *sprite = sprite_new(&extent);
+    guint8 *covered = dedup ? g_malloc0((BENCH_WIDTH * BENCH_HEIGHT + 7) / 8) : NULL;
+    double half = extent / 2;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        double px = round(x[i]);
+        double py = round(y[i]);
+
+        if (covered != NULL && px >= 0 && py >= 0 && px < BENCH_WIDTH && py < BENCH_HEIGHT)
+        {
+            size_t bit = (size_t) py * BENCH_WIDTH + (size_t) px;
+
+            if (covered[bit / 8] & (1u << (bit % 8)))
+            {
+                continue;
+            }
+            covered[bit / 8] |= 1u << (bit % 8);
+        }
+
+        cairo_set_source_surface(cr, sprite, px - half, py - half);
+        cairo_rectangle(cr, px - half, py - half, extent, extent);
+        cairo_fill(cr);
+    }
+    cairo_surface_flush(surface);
+
+    double ms = bench_ms(start);
+    g_free(covered);
+    cairo_surface_destroy(sprite);
+    cairo_destroy(cr);
+
+    return ms;
+}
+
+int main(void)
+{
+    const size_t sizes[] = { 100000, 1000000 };
+    cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, BENCH_WIDTH, BENCH_HEIGHT);
+
+    printf("%10s %12s %12s %12s %12s\n", "points", "stroke [ms]", "path [ms]", "sprite [ms]", "once [ms]");
+
+    for (size_t s = 0; s < G_N_ELEMENTS(sizes); s++)
+    {
+        size_t n = sizes[s];
+        double *x = g_new(double, n);
+        double *y = g_new(double, n);
+
+        bench_generate(x, y, n);
+
+        double stroke_ms = draw_per_point_stroke(surface, x, y, n);
+        double path_ms = draw_single_path(surface, x, y, n);
+        double sprite_ms = draw_sprite(surface, x, y, n, FALSE);
+        double once_ms = draw_sprite(surface, x, y, n, TRUE);
+
+        printf("%10zu %12.1f %12.1f %12.1f %12.1f\n", n, stroke_ms, path_ms, sprite_ms, once_ms);
+
+        g_free(x);
+        g_free(y);
+    }
+
+    cairo_surface_destroy(surface);
+
+    return 0;
+}
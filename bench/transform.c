@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2022  Martin Lund
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Throughput of the data to plot coordinate transform kernels, against memcpy of the same bytes
+
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+#include "gtkchart-simd.h"
+
+#define REPEAT 10
+
+// Bytes read and written per point: x, y in, px, py and mask out
+#define POINT_BYTES (4 * sizeof(double) + 1)
+
+static double run_kernel(chart_transform_func_t kernel,
+                         const struct chart_transform_t *transform,
+                         const double *x,
+                         const double *y,
+                         size_t n,
+                         size_t chunk,
+                         double *px,
+                         double *py,
+                         guint8 *mask,
+                         int passes)
+{
+    double best = G_MAXDOUBLE;
+
+    for (int r = 0; r < REPEAT; r++)
+    {
+        gint64 start = g_get_monotonic_time();
+
+        // Chunks model the batches the chart feeds the kernel
+        for (int pass = 0; pass < passes; pass++)
+        {
+            for (size_t i = 0; i < n; i += chunk)
+            {
+                size_t count = MIN(chunk, n - i);
+
+                kernel(transform, x + i, y + i, count, px + i, py + i, mask + i);
+            }
+        }
+
+        best = MIN(best, bench_ms(start) / passes);
+    }
+
+    return best;
+}
+
+static double run_memcpy(guint8 *dest, const guint8 *src, size_t n_bytes, int passes)
+{
+    double best = G_MAXDOUBLE;
+
+    for (int r = 0; r < REPEAT; r++)
+    {
+        gint64 start = g_get_monotonic_time();
+
+        for (int pass = 0; pass < passes; pass++)
+        {
+            memcpy(dest, src, n_bytes);
+        }
+        best = MIN(best, bench_ms(start) / passes);
+    }
+
+    return best;
+}
+
+static void bench_size(size_t n, size_t chunk)
+{
+    double *x = g_new(double, n);
+    double *y = g_new(double, n);
+    double *px = g_new(double, n);
+    double *py = g_new(double, n);
+    guint8 *mask = g_new(guint8, n);
+    struct chart_transform_t transform =
+    {
+        .x_origin = 0,
+        .y_origin = 0,
+        .x_scale = 0.5,
+        .y_scale = 0.5,
+        .x_min = BENCH_WIDTH * 0.25,
+        .x_max = BENCH_WIDTH * 0.75,
+        .y_min = BENCH_HEIGHT * 0.25,
+        .y_max = BENCH_HEIGHT * 0.75,
+    };
+
+    // Small sizes repeat to get measurable times
+    int passes = (int) MAX(1, (64 << 20) / (n * POINT_BYTES));
+
+    bench_generate(x, y, n);
+    memset(px, 0, n * sizeof(double));
+    memset(py, 0, n * sizeof(double));
+    memset(mask, 0, n);
+
+    // Reference moving as many bytes, half read and half written. For large copies memcpy
+    // may use non-temporal stores that skip reading the destination, which the kernel cannot.
+    size_t n_bytes = n * POINT_BYTES / 2;
+    guint8 *src = g_malloc(n_bytes);
+    guint8 *dest = g_malloc(n_bytes);
+    memset(src, 1, n_bytes);
+    memset(dest, 0, n_bytes);
+    double memcpy_ms = run_memcpy(dest, src, n_bytes, passes);
+
+    printf("%10zu points, %zu per batch, memcpy %.2f GB/s\n", n, chunk, 2 * n_bytes / memcpy_ms / 1e6);
+    printf("%10s %12s %12s %12s\n", "kernel", "time [ms]", "GB/s", "of memcpy");
+
+    for (enum chart_simd_t simd = CHART_SIMD_SCALAR; simd <= CHART_SIMD_NEON; simd++)
+    {
+        chart_transform_func_t kernel = chart_transform_kernel(simd);
+
+        if (kernel == NULL)
+        {
+            continue;
+        }
+
+        double ms = run_kernel(kernel, &transform, x, y, n, chunk, px, py, mask, passes);
+        double gbs = n * POINT_BYTES / ms / 1e6;
+
+        printf("%10s %12.3f %12.2f %11.0f%%\n", chart_simd_name(simd), ms, gbs,
+               100 * gbs / (2 * n_bytes / memcpy_ms / 1e6));
+    }
+    printf("\n");
+
+    g_free(src);
+    g_free(dest);
+    g_free(x);
+    g_free(y);
+    g_free(px);
+    g_free(py);
+    g_free(mask);
+}
+
+int main(void)
+{
+    printf("best kernel: %s\n\n", chart_simd_name(chart_simd_best()));
+
+    // Fits in cache, measures the arithmetic
+    bench_size(4096, 256);
+
+    // Streams through memory
+    bench_size(16 * 1000 * 1000, 256);
+    bench_size(16 * 1000 * 1000, 16 * 1000 * 1000);
+
+    return 0;
+}
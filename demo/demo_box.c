@@ -108,6 +108,7 @@ static void demo_box_init(DemoBox *self)
     gtk_chart_set_x_max(line_chart, VIEWPORT_WIDTH);
     gtk_chart_set_y_min(line_chart, -3.5);
     gtk_chart_set_y_max(line_chart, 3.5);
+    gtk_chart_set_strip_chart(line_chart, true);
     gtk_widget_set_hexpand(GTK_WIDGET(line_chart), TRUE);
     gtk_widget_set_vexpand(GTK_WIDGET(line_chart), TRUE);
     gtk_box_append(GTK_BOX(hbox1), GTK_WIDGET(line_chart));
@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) 2022  Martin Lund
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Data to plot coordinate transform with SSE2, AVX2 and NEON variants picked at runtime.
+// Variants are compiled with per function target attributes, so the library itself keeps
+// building for the baseline instruction set.
+
+#include <string.h>
+#include "gtkchart-simd.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CHART_SIMD_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define CHART_SIMD_ARM64 1
+#endif
+
+static size_t chart_transform_scalar(const struct chart_transform_t *t,
+                                     const double *x,
+                                     const double *y,
+                                     size_t n,
+                                     double *px,
+                                     double *py,
+                                     guint8 *mask)
+{
+    size_t visible = 0;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        int inside = (x[i] >= t->x_min) & (x[i] <= t->x_max) & (y[i] >= t->y_min) & (y[i] <= t->y_max);
+
+        px[i] = (x[i] - t->x_origin) * t->x_scale;
+        py[i] = (y[i] - t->y_origin) * t->y_scale;
+        mask[i] = (guint8) inside;
+        visible += inside;
+    }
+
+    return visible;
+}
+
+#ifdef CHART_SIMD_X86
+
+__attribute__((target("sse2")))
+static size_t chart_transform_sse2(const struct chart_transform_t *t,
+                                   const double *x,
+                                   const double *y,
+                                   size_t n,
+                                   double *px,
+                                   double *py,
+                                   guint8 *mask)
+{
+    __m128d x_origin = _mm_set1_pd(t->x_origin);
+    __m128d y_origin = _mm_set1_pd(t->y_origin);
+    __m128d x_scale = _mm_set1_pd(t->x_scale);
+    __m128d y_scale = _mm_set1_pd(t->y_scale);
+    __m128d x_min = _mm_set1_pd(t->x_min);
+    __m128d x_max = _mm_set1_pd(t->x_max);
+    __m128d y_min = _mm_set1_pd(t->y_min);
+    __m128d y_max = _mm_set1_pd(t->y_max);
+    size_t visible = 0;
+    size_t i = 0;
+
+    for (; i + 2 <= n; i += 2)
+    {
+        __m128d vx = _mm_loadu_pd(x + i);
+        __m128d vy = _mm_loadu_pd(y + i);
+
+        _mm_storeu_pd(px + i, _mm_mul_pd(_mm_sub_pd(vx, x_origin), x_scale));
+        _mm_storeu_pd(py + i, _mm_mul_pd(_mm_sub_pd(vy, y_origin), y_scale));
+
+        // Ordered compares, NAN is outside
+        __m128d inside = _mm_and_pd(_mm_and_pd(_mm_cmpge_pd(vx, x_min), _mm_cmple_pd(vx, x_max)),
+                                    _mm_and_pd(_mm_cmpge_pd(vy, y_min), _mm_cmple_pd(vy, y_max)));
+        int bits = _mm_movemask_pd(inside);
+
+        mask[i] = bits & 1;
+        mask[i + 1] = bits >> 1;
+        visible += (bits & 1) + (bits >> 1);
+    }
+
+    return visible + chart_transform_scalar(t, x + i, y + i, n - i, px + i, py + i, mask + i);
+}
+
+__attribute__((target("avx2")))
+static size_t chart_transform_avx2(const struct chart_transform_t *t,
+                                   const double *x,
+                                   const double *y,
+                                   size_t n,
+                                   double *px,
+                                   double *py,
+                                   guint8 *mask)
+{
+    // Mask bytes of four lanes by compare bits
+    static const guint32 lanes[16] =
+    {
+        0x00000000, 0x00000001, 0x00000100, 0x00000101, 0x00010000, 0x00010001, 0x00010100, 0x00010101,
+        0x01000000, 0x01000001, 0x01000100, 0x01000101, 0x01010000, 0x01010001, 0x01010100, 0x01010101
+    };
+    __m256d x_origin = _mm256_set1_pd(t->x_origin);
+    __m256d y_origin = _mm256_set1_pd(t->y_origin);
+    __m256d x_scale = _mm256_set1_pd(t->x_scale);
+    __m256d y_scale = _mm256_set1_pd(t->y_scale);
+    __m256d x_min = _mm256_set1_pd(t->x_min);
+    __m256d x_max = _mm256_set1_pd(t->x_max);
+    __m256d y_min = _mm256_set1_pd(t->y_min);
+    __m256d y_max = _mm256_set1_pd(t->y_max);
+    size_t visible = 0;
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256d vx = _mm256_loadu_pd(x + i);
+        __m256d vy = _mm256_loadu_pd(y + i);
+
+        _mm256_storeu_pd(px + i, _mm256_mul_pd(_mm256_sub_pd(vx, x_origin), x_scale));
+        _mm256_storeu_pd(py + i, _mm256_mul_pd(_mm256_sub_pd(vy, y_origin), y_scale));
+
+        __m256d inside = _mm256_and_pd(_mm256_and_pd(_mm256_cmp_pd(vx, x_min, _CMP_GE_OQ),
+                                                     _mm256_cmp_pd(vx, x_max, _CMP_LE_OQ)),
+                                       _mm256_and_pd(_mm256_cmp_pd(vy, y_min, _CMP_GE_OQ),
+                                                     _mm256_cmp_pd(vy, y_max, _CMP_LE_OQ)));
+        int bits = _mm256_movemask_pd(inside);
+
+        memcpy(mask + i, &lanes[bits], 4);
+        visible += __builtin_popcount(bits);
+    }
+
+    return visible + chart_transform_scalar(t, x + i, y + i, n - i, px + i, py + i, mask + i);
+}
+
+#endif
+
+#ifdef CHART_SIMD_ARM64
+
+static size_t chart_transform_neon(const struct chart_transform_t *t,
+                                   const double *x,
+                                   const double *y,
+                                   size_t n,
+                                   double *px,
+                                   double *py,
+                                   guint8 *mask)
+{
+    float64x2_t x_origin = vdupq_n_f64(t->x_origin);
+    float64x2_t y_origin = vdupq_n_f64(t->y_origin);
+    float64x2_t x_scale = vdupq_n_f64(t->x_scale);
+    float64x2_t y_scale = vdupq_n_f64(t->y_scale);
+    float64x2_t x_min = vdupq_n_f64(t->x_min);
+    float64x2_t x_max = vdupq_n_f64(t->x_max);
+    float64x2_t y_min = vdupq_n_f64(t->y_min);
+    float64x2_t y_max = vdupq_n_f64(t->y_max);
+    size_t visible = 0;
+    size_t i = 0;
+
+    for (; i + 2 <= n; i += 2)
+    {
+        float64x2_t vx = vld1q_f64(x + i);
+        float64x2_t vy = vld1q_f64(y + i);
+
+        vst1q_f64(px + i, vmulq_f64(vsubq_f64(vx, x_origin), x_scale));
+        vst1q_f64(py + i, vmulq_f64(vsubq_f64(vy, y_origin), y_scale));
+
+        uint64x2_t inside = vandq_u64(vandq_u64(vcgeq_f64(vx, x_min), vcleq_f64(vx, x_max)),
+                                      vandq_u64(vcgeq_f64(vy, y_min), vcleq_f64(vy, y_max)));
+        guint8 first = (guint8) (vgetq_lane_u64(inside, 0) & 1);
+        guint8 second = (guint8) (vgetq_lane_u64(inside, 1) & 1);
+
+        mask[i] = first;
+        mask[i + 1] = second;
+        visible += first + second;
+    }
+
+    return visible + chart_transform_scalar(t, x + i, y + i, n - i, px + i, py + i, mask + i);
+}
+
+#endif
+
+// Kernel of instruction set, NULL if the build or CPU lacks it
+chart_transform_func_t chart_transform_kernel(enum chart_simd_t simd)
+{
+    switch (simd)
+    {
+        case CHART_SIMD_SCALAR:
+            return chart_transform_scalar;
+#ifdef CHART_SIMD_X86
+        case CHART_SIMD_SSE2:
+            return __builtin_cpu_supports("sse2") ? chart_transform_sse2 : NULL;
+        case CHART_SIMD_AVX2:
+            return __builtin_cpu_supports("avx2") ? chart_transform_avx2 : NULL;
+#endif
+#ifdef CHART_SIMD_ARM64
+        case CHART_SIMD_NEON:
+            // Part of the base instruction set
+            return chart_transform_neon;
+#endif
+        default:
+            return NULL;
+    }
+}
+
+const char * chart_simd_name(enum chart_simd_t simd)
+{
+    static const char *names[] = { "scalar", "sse2", "avx2", "neon" };
+
+    return names[simd];
+}
+
+// Widest instruction set supported, detected once
+enum chart_simd_t chart_simd_best(void)
+{
+    static gsize best = 0;
+
+    if (g_once_init_enter(&best))
+    {
+        enum chart_simd_t simd = CHART_SIMD_SCALAR;
+
+        if (chart_transform_kernel(CHART_SIMD_NEON) != NULL)
+        {
+            simd = CHART_SIMD_NEON;
+        }
+        else if (chart_transform_kernel(CHART_SIMD_AVX2) != NULL)
+        {
+            simd = CHART_SIMD_AVX2;
+        }
+        else if (chart_transform_kernel(CHART_SIMD_SSE2) != NULL)
+        {
+            simd = CHART_SIMD_SSE2;
+        }
+
+        // Stored off by one, zero means not yet detected
+        g_once_init_leave(&best, simd + 1);
+    }
+
+    return (enum chart_simd_t) (best - 1);
+}
+
+size_t chart_transform(const struct chart_transform_t *transform,
+                       const double *x,
+                       const double *y,
+                       size_t n,
+                       double *px,
+                       double *py,
+                       guint8 *mask)
+{
+    return chart_transform_kernel(chart_simd_best())(transform, x, y, n, px, py, mask);
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2022  Martin Lund
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holders nor contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <glib.h>
+
+// Vectorized kernels for mapping data to plot coordinates, internal to the library
+
+enum chart_simd_t
+{
+    CHART_SIMD_SCALAR,
+    CHART_SIMD_SSE2,
+    CHART_SIMD_AVX2,
+    CHART_SIMD_NEON
+};
+
+// Maps data x/y to plot coordinates (x - x_origin) * x_scale and (y - y_origin) * y_scale,
+// points are visible inside [x_min, x_max] x [y_min, y_max]
+struct chart_transform_t
+{
+    double x_origin;
+    double y_origin;
+    double x_scale;
+    double y_scale;
+    double x_min;
+    double x_max;
+    double y_min;
+    double y_max;
+};
+
+// Transform n points into px/py and set mask to 1 for visible points, 0 otherwise (also for NAN).
+// Returns number of visible points.
+typedef size_t (*chart_transform_func_t)(const struct chart_transform_t *transform,
+                                         const double *x,
+                                         const double *y,
+                                         size_t n,
+                                         double *px,
+                                         double *py,
+                                         guint8 *mask);
+
+G_GNUC_INTERNAL enum chart_simd_t chart_simd_best(void);
+G_GNUC_INTERNAL const char * chart_simd_name(enum chart_simd_t simd);
+G_GNUC_INTERNAL chart_transform_func_t chart_transform_kernel(enum chart_simd_t simd);
+G_GNUC_INTERNAL size_t chart_transform(const struct chart_transform_t *transform,
+                                       const double *x,
+                                       const double *y,
+                                       size_t n,
+                                       double *px,
+                                       double *py,
+                                       guint8 *mask);
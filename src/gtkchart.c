@@ -29,7 +29,9 @@
  */
 
 #include <ctype.h>
+#include <stdatomic.h>
 #include "gtkchart.h"
+#include "gtkchart-simd.h"
 #include "glib.h"
 
 #define UNUSED(expr) do { (void)(expr); } while (0)
@@ -40,6 +42,89 @@ struct chart_point_t
     double y;
 };
 
+struct chart_pyramid_level_t
+{
+    double *min;
+    double *max;
+    guint64 *block;   // Block number stored in slot
+    size_t *count;    // Number of samples summarized in slot
+    size_t size;      // Number of slots
+};
+
+// Min/max summaries over aligned blocks of 2^(CHART_PYRAMID_SHIFT + k) samples at level k
+struct chart_pyramid_t
+{
+    struct chart_pyramid_level_t *levels;
+    unsigned int n_levels;
+};
+
+// Y samples of one series, stored in the slots of the shared x column
+struct chart_ring_series_t
+{
+    void *y;          // Samples in ring storage format, NAN where series has no sample
+    struct chart_pyramid_t pyramid;
+};
+
+// Summary of one series in a history block, NAN samples excluded from min/max
+struct chart_history_column_t
+{
+    size_t offset;    // Bit offset of encoded samples in block data
+    double min;       // min > max if block holds no sample of series
+    double max;
+    double first;     // Samples of first and last point, may be NAN
+    double last;
+    gboolean gaps;    // Some points have no sample of series
+};
+
+// Gorilla compressed block of points evicted from the ring, x as delta-of-delta
+// of its bit pattern followed by each series XORed with its previous sample
+struct chart_history_block_t
+{
+    size_t count;
+    double x_min;
+    double x_max;
+    double x_first;
+    double x_last;
+    guint8 *data;     // NULL while block is open
+    size_t n_bytes;
+    unsigned int n_series;
+    struct chart_history_column_t columns[];
+};
+
+// Points evicted from the ring, oldest first. Full blocks are sealed (compressed),
+// the newest block stays open and uncompressed until it fills up.
+struct chart_history_t
+{
+    size_t capacity;  // Points kept, rounded up to whole blocks (0 = disabled)
+    GPtrArray *blocks;// Sealed blocks from index first onwards
+    guint first;
+    size_t count;     // Points in sealed blocks
+    size_t bytes;     // Memory held by sealed blocks
+    struct chart_history_block_t *open;
+    double *open_x;
+    double *open_y;   // CHART_HISTORY_BLOCK samples per series of open block
+};
+
+struct chart_ring_t
+{
+    GtkChartStorage storage;
+    void *x;          // Samples in ring storage format, NULL for uniform x
+    double x_start;   // Uniform x of point with sequence number seq is
+    double x_step;    // x_start + (seq - x_base) * x_step
+    guint64 x_base;
+    double y_offset;  // Int16 y is y_offset + sample * y_step
+    double y_step;
+    struct chart_ring_series_t *series;
+    unsigned int n_series;
+    size_t size;      // Number of allocated slots
+    size_t capacity;  // Maximum number of points retained (0 = unbounded)
+    size_t head;      // Slot of oldest point
+    size_t count;     // Number of points stored
+    guint64 total;    // Number of points ever pushed, sequence number of next point
+    guint64 disorder; // Sequence number of newest point with x below its predecessor
+    struct chart_history_t history;
+};
+
 struct chart_slice_t
 {
     double value;
@@ -54,9 +139,137 @@ struct chart_column_t
   gchar *label;
 };
 
-struct _GtkChart
+struct chart_axes_key_t
+{
+    float w;
+    float h;
+    double x_min;
+    double x_max;
+    double y_min;
+    double y_max;
+    GdkRGBA text_color;
+    GdkRGBA grid_color;
+    GdkRGBA axis_color;
+    guint text_serial;
+};
+
+// Inputs of the rasterized strip chart data layer, any change forces a full redraw
+struct chart_strip_key_t
+{
+    double plot_width;
+    double plot_height;
+    int scale;
+    double x_span;
+    double y_min;
+    double y_max;
+    GdkRGBA color;
+    GtkChartType type;
+    GtkChartDownsample downsample;
+    unsigned int downsample_budget;
+    GtkChartMarker marker_shape;
+    double marker_size;
+    guint series_serial;
+    guint data_serial;
+    guint64 disorder;
+};
+
+// Offscreen data layer of strip charts, scrolled instead of redrawn
+struct chart_strip_t
+{
+    gboolean enabled;
+    cairo_surface_t *surface;   // Plot area plus a vertical margin, one extra column for sub pixel offsets
+    struct chart_strip_key_t key;
+    double x_origin;            // Data x at left edge of surface
+    guint64 total;              // Ring sequence number of next point not yet rendered
+    guint64 first_seq;          // Oldest point in ring when last rendered
+    double last_x;              // X of newest rendered point
+};
+
+// Summary of CHART_MAPPED_BLOCK consecutive records of a mapped file, records are sorted by x
+struct chart_mapped_block_t
+{
+    double x_first;
+    double x_last;
+};
+
+struct chart_mapped_column_t
+{
+    double first;
+    double last;
+    double min;             // Over samples other than NAN, min > max if there are none
+    double max;
+    gboolean gaps;          // Some samples are NAN
+};
+
+// Read-only series file mapped into memory, records of x followed by one y per series
+// as little-endian doubles, sorted by x
+struct chart_mapped_t
+{
+    GMappedFile *file;
+    const guint8 *records;
+    size_t count;
+    size_t stride;          // Bytes per record
+    unsigned int n_series;
+    struct chart_mapped_block_t *blocks;    // Built on open, lets wide views skip reading records
+    struct chart_mapped_column_t *columns;  // Series s of block b at b * n_series + s
+    size_t n_blocks;
+};
+
+// Header of chart snapshot file, all fields little-endian with doubles stored as their bit patterns.
+// Followed by one entry per series and then the columns, each aligned to CHART_BINARY_ALIGN bytes.
+struct chart_binary_header_t
+{
+    char magic[8];
+    guint32 version;
+    guint32 n_series;
+    guint64 count;
+    guint32 storage;        // GtkChartStorage of columns
+    guint32 reserved;
+    guint64 x_start;        // Uniform x of first point
+    guint64 x_step;
+    guint64 y_offset;       // Int16 y is y_offset + sample * y_step
+    guint64 y_step;
+    guint64 x_min;          // Axis ranges
+    guint64 x_max;
+    guint64 y_min;
+    guint64 y_max;
+    guint64 x_offset;       // File offset of x column, 0 for uniform x
+    guint64 padding[3];
+};
+
+struct chart_binary_series_t
+{
+    guint64 offset;         // File offset of y column
+    guint32 color[4];       // RGBA of the series as float bit patterns, series 0 is the line color
+    guint64 reserved;
+};
+
+G_STATIC_ASSERT(sizeof(struct chart_binary_header_t) == 128);
+G_STATIC_ASSERT(sizeof(struct chart_binary_series_t) == 32);
+
+// Marker sprite, rendered once and stamped at every scatter point
+struct chart_marker_t
+{
+    GtkChartMarker shape;
+    double size;            // Marker width in logical pixels
+    GdkRGBA color;
+    int scale;              // Device scale the sprite was rendered for
+    double extent;          // Sprite width in logical pixels, marker plus antialiasing margin
+    cairo_surface_t *surface;
+    GdkTexture *texture;
+};
+
+// Series after the first, which is styled by the chart line color
+struct chart_series_t
+{
+    GdkRGBA color;
+    struct chart_marker_t marker;
+};
+
+// Chart data and settings read by the renderer. A plain struct, so offscreen exports can
+// take a copy and draw it on a worker thread without touching the widget.
+struct chart_state_t
 {
-    GtkWidget parent_instance;
     GtkChartType type;
     char *title;
     char *label;
@@ -70,17 +283,49 @@ struct _GtkChart
     double value_min;
     double value_max;
     int width;
-    void *user_data;
+    struct chart_ring_t points;
+    struct chart_point_t *point_cache;
     GSList *point_list;
+    gboolean point_list_stale;
     GSList *slice_list;
     GSList *column_list;
-    GtkSnapshot *snapshot;
     GdkRGBA text_color;
     GdkRGBA line_color;
     GdkRGBA grid_color;
     GdkRGBA axis_color;
     gchar *font_name;
     int ticks;
+    GtkChartDownsample downsample;
+    unsigned int downsample_budget;
+    guint text_serial;
+    GskRenderNode *axes_node;
+    struct chart_axes_key_t axes_key;
+    gboolean axes_valid;
+    struct chart_marker_t marker;
+    struct chart_strip_t strip;
+    GSList *series_list;
+    guint series_serial;
+    guint data_serial;      // Bumped when stored points change other than by appending
+    struct chart_mapped_t mapped;
+    struct chart_export_t *export;  // Set in offscreen copies of chart state
+    gboolean tiled;         // Rasterize data layer in tiles on worker threads
+    unsigned int density;   // Scatter density cell size in device pixels (0 = draw markers)
+    int csv_precision;      // CSV decimals, -1 for round-trip
+    char csv_delimiter;
+    int scale;              // Device scale of the target, set before drawing
+    PangoContext *pango_context;    // Widget text context while drawing, NULL offscreen
+};
+
+struct _GtkChart
+{
+    GtkWidget parent_instance;
+    struct chart_state_t state;
+    void *user_data;
+    GtkSnapshot *snapshot;
+    gboolean dirty;
+    guint tick_id;
+    double max_fps;
+    gint64 last_draw_time;
 };
 
 struct _GtkChartClass
@@ -88,1180 +333,7491 @@ struct _GtkChartClass
     GtkWidgetClass parent_class;
 };
 
+// Single producer, single consumer queue of points, drained by the chart once per frame.
+// Producer and consumer indices live on separate cache lines.
+struct _GtkChartWriter
+{
+    GtkChart *chart;
+    guint tick_id;              // Drain tick, only runs while points are queued
+    gboolean closed;
+    gatomicrefcount ref_count;  // Owner plus pending re-arm requests
+    unsigned int n_values;      // Values per point, x followed by one y per series
+    size_t capacity;            // Points, power of two
+    double *slots;
+    _Alignas(64) atomic_size_t head;    // Next point to write, advanced by producer
+    size_t tail_cache;                  // Producer's last view of tail
+    atomic_uint_least64_t dropped;
+    atomic_bool armed;                  // Drain tick running or requested
+    _Alignas(64) atomic_size_t tail;    // Next point to read, advanced by consumer
+};
+
 G_DEFINE_TYPE (GtkChart, gtk_chart, GTK_TYPE_WIDGET)
 
-static void gtk_chart_init(GtkChart *self)
+#define CHART_RING_MIN_SIZE 1024
+#define CHART_PYRAMID_SHIFT 6
+#define CHART_HISTORY_BLOCK 1024
+#define CHART_MAPPED_MAGIC "GCSERIES"
+#define CHART_MAPPED_VERSION 1
+#define CHART_MAPPED_HEADER_SIZE 16
+#define CHART_MAPPED_MAX_SERIES 1024
+#define CHART_MAPPED_BLOCK 256
+#define CHART_BINARY_MAGIC "GCCOLUMN"
+#define CHART_BINARY_VERSION 1
+#define CHART_BINARY_ALIGN 64
+#define CHART_BINARY_MAX_SERIES CHART_MAPPED_MAX_SERIES
+
+// Map logical point index (0 = oldest) to ring slot
+static inline size_t chart_ring_slot(const struct chart_ring_t *ring, size_t index)
 {
-    // Defaults
-    self->type = GTK_CHART_TYPE_UNKNOWN;
-    self->title = NULL;
-    self->label = NULL;
-    self->x_label = NULL;
-    self->y_label = NULL;
-    self->x_max = 100;
-    self->y_max = 100;
-    self->value_min = 0;
-    self->value_max = 100;
-    self->width = 500;
-    self->snapshot = NULL;
-    self->text_color.alpha = -1.0;
-    self->line_color.alpha = -1.0;
-    self->grid_color.alpha = -1.0;
-    self->axis_color.alpha = -1.0;
-    self->font_name = NULL;
-    self->ticks = 4;
+    size_t slot = ring->head + index;
 
-    // Automatically use GTK font
-    GtkSettings *widget_settings = gtk_widget_get_settings(&self->parent_instance);
-    GValue font_name_value = G_VALUE_INIT;
-    g_object_get_property(G_OBJECT (widget_settings), "gtk-font-name", &font_name_value);
-    gchar *font_string = g_strdup_value_contents(&font_name_value);
+    return (slot >= ring->size) ? slot - ring->size : slot;
+}
 
-    // Extract name of font from font string ("<name> <size>")
-    gchar *font_name = &font_string[1]; // Skip "
-    for (unsigned int i=0; i<strlen(font_name); i++)
+// Sequence number of oldest point
+static inline guint64 chart_ring_first_seq(const struct chart_ring_t *ring)
+{
+    return ring->total - ring->count;
+}
+
+static inline size_t chart_history_n_points(const struct chart_history_t *history)
+{
+    return history->count + (history->open ? history->open->count : 0);
+}
+
+// Sequence number of oldest point kept in history or ring
+static inline guint64 chart_ring_oldest_seq(const struct chart_ring_t *ring)
+{
+    return chart_ring_first_seq(ring) - chart_history_n_points(&ring->history);
+}
+
+// True if x never decreases over stored points, including those kept in history
+static inline gboolean chart_ring_is_monotonic(const struct chart_ring_t *ring)
+{
+    return ring->disorder <= chart_ring_oldest_seq(ring);
+}
+
+static inline gboolean chart_storage_is_uniform(GtkChartStorage storage)
+{
+    return storage == GTK_CHART_STORAGE_UNIFORM_FLOAT || storage == GTK_CHART_STORAGE_UNIFORM_INT16;
+}
+
+// Bytes per stored x sample
+static inline size_t chart_storage_x_size(GtkChartStorage storage)
+{
+    switch (storage)
     {
-        if (isdigit((int)font_name[i]))
+        case GTK_CHART_STORAGE_DOUBLE:
+            return sizeof(double);
+        case GTK_CHART_STORAGE_FLOAT:
+            return sizeof(float);
+        default:
+            return 0;
+    }
+}
+
+// Bytes per stored y sample
+static inline size_t chart_storage_y_size(GtkChartStorage storage)
+{
+    switch (storage)
+    {
+        case GTK_CHART_STORAGE_DOUBLE:
+            return sizeof(double);
+        case GTK_CHART_STORAGE_UNIFORM_INT16:
+            return sizeof(gint16);
+        default:
+            return sizeof(float);
+    }
+}
+
+// X implied by sequence number in uniform storage
+static inline double chart_ring_uniform_x(const struct chart_ring_t *ring, guint64 seq)
+{
+    return ring->x_start + (double) (gint64) (seq - ring->x_base) * ring->x_step;
+}
+
+// X of point stored in slot
+static inline double chart_ring_x(const struct chart_ring_t *ring, size_t slot)
+{
+    switch (ring->storage)
+    {
+        case GTK_CHART_STORAGE_DOUBLE:
+            return ((const double *) ring->x)[slot];
+        case GTK_CHART_STORAGE_FLOAT:
+            return ((const float *) ring->x)[slot];
+        default:
         {
-            font_name[i-1] = 0;
-            break;
+            size_t index = (slot >= ring->head) ? slot - ring->head : slot + ring->size - ring->head;
+            return chart_ring_uniform_x(ring, chart_ring_first_seq(ring) + index);
         }
     }
-    self->font_name = g_strdup(font_name);
-    g_free(font_string);
+}
 
-    //gtk_widget_init_template (GTK_WIDGET (self));
+// Y of series for point stored in slot
+static inline double chart_ring_y(const struct chart_ring_t *ring, unsigned int series, size_t slot)
+{
+    const void *y = ring->series[series].y;
+
+    switch (ring->storage)
+    {
+        case GTK_CHART_STORAGE_DOUBLE:
+            return ((const double *) y)[slot];
+        case GTK_CHART_STORAGE_UNIFORM_INT16:
+        {
+            gint16 sample = ((const gint16 *) y)[slot];
+            return (sample == G_MININT16) ? NAN : ring->y_offset + sample * ring->y_step;
+        }
+        default:
+            return ((const float *) y)[slot];
+    }
 }
 
-static void gtk_chart_finalize (GObject *object)
+// Store x of point in slot, uniform x is implied by the sequence number
+static inline void chart_ring_set_x(struct chart_ring_t *ring, size_t slot, double x)
 {
-    GtkChart *self = GTK_CHART (object);
+    switch (ring->storage)
+    {
+        case GTK_CHART_STORAGE_DOUBLE:
+            ((double *) ring->x)[slot] = x;
+            break;
+        case GTK_CHART_STORAGE_FLOAT:
+            ((float *) ring->x)[slot] = (float) x;
+            break;
+        default:
+            break;
+    }
+}
 
-    G_OBJECT_CLASS (gtk_chart_parent_class)->finalize (G_OBJECT (self));
+// Store y of series for point in slot, int16 samples are rounded and saturated, G_MININT16 marks NAN
+static inline void chart_ring_set_y(struct chart_ring_t *ring, unsigned int series, size_t slot, double y)
+{
+    void *data = ring->series[series].y;
+
+    switch (ring->storage)
+    {
+        case GTK_CHART_STORAGE_DOUBLE:
+            ((double *) data)[slot] = y;
+            break;
+        case GTK_CHART_STORAGE_UNIFORM_INT16:
+            if (isnan(y))
+            {
+                ((gint16 *) data)[slot] = G_MININT16;
+            }
+            else
+            {
+                double sample = round((y - ring->y_offset) / ring->y_step);
+                ((gint16 *) data)[slot] = (gint16) CLAMP(sample, -G_MAXINT16, G_MAXINT16);
+            }
+            break;
+        default:
+            ((float *) data)[slot] = (float) y;
+            break;
+    }
 }
 
-static void gtk_chart_dispose (GObject *object)
+// Value x and y read back as after storing them
+static inline double chart_ring_stored_x(const struct chart_ring_t *ring, double x)
 {
-    GtkChart *self = GTK_CHART (object);
-    GtkWidget *child;
+    return (ring->storage == GTK_CHART_STORAGE_FLOAT) ? (float) x : x;
+}
 
-    while ((child = gtk_widget_get_first_child (GTK_WIDGET (object))))
+static inline double chart_ring_stored_y(const struct chart_ring_t *ring, double y)
+{
+    switch (ring->storage)
     {
-        gtk_widget_unparent (child);
+        case GTK_CHART_STORAGE_DOUBLE:
+            return y;
+        case GTK_CHART_STORAGE_UNIFORM_INT16:
+            return isnan(y) ? NAN : ring->y_offset + CLAMP(round((y - ring->y_offset) / ring->y_step),
+                                                           -G_MAXINT16, G_MAXINT16) * ring->y_step;
+        default:
+            return (float) y;
     }
+}
 
-    // Cleanup
-    g_free(self->title);
-    g_free(self->label);
-    g_free(self->x_label);
-    g_free(self->y_label);
+// Convert n points from logical index onwards to doubles, either output may be NULL.
+// Storage format is resolved once per contiguous run of slots instead of per sample.
+static void chart_ring_load(const struct chart_ring_t *ring,
+                            unsigned int series,
+                            size_t index,
+                            size_t n,
+                            double *x,
+                            double *y)
+{
+    while (n > 0)
+    {
+        size_t slot = chart_ring_slot(ring, index);
+        size_t run = MIN(n, ring->size - slot);
 
-    g_clear_slist(&self->point_list, g_free);
+        if (x != NULL)
+        {
+            switch (ring->storage)
+            {
+                case GTK_CHART_STORAGE_DOUBLE:
+                    memcpy(x, (const double *) ring->x + slot, run * sizeof(double));
+                    break;
+                case GTK_CHART_STORAGE_FLOAT:
+                {
+                    const float *data = (const float *) ring->x + slot;
+                    for (size_t i = 0; i < run; i++)
+                    {
+                        x[i] = data[i];
+                    }
+                    break;
+                }
+                default:
+                {
+                    double first = chart_ring_uniform_x(ring, chart_ring_first_seq(ring) + index);
+                    for (size_t i = 0; i < run; i++)
+                    {
+                        x[i] = first + (double) i * ring->x_step;
+                    }
+                    break;
+                }
+            }
+            x += run;
+        }
 
-    g_clear_slist(&self->slice_list, g_free);
+        if (y != NULL)
+        {
+            const void *data = ring->series[series].y;
 
-    gdk_display_sync(gdk_display_get_default());
+            switch (ring->storage)
+            {
+                case GTK_CHART_STORAGE_DOUBLE:
+                    memcpy(y, (const double *) data + slot, run * sizeof(double));
+                    break;
+                case GTK_CHART_STORAGE_UNIFORM_INT16:
+                {
+                    const gint16 *samples = (const gint16 *) data + slot;
+                    for (size_t i = 0; i < run; i++)
+                    {
+                        y[i] = (samples[i] == G_MININT16) ? NAN : ring->y_offset + samples[i] * ring->y_step;
+                    }
+                    break;
+                }
+                default:
+                {
+                    const float *samples = (const float *) data + slot;
+                    for (size_t i = 0; i < run; i++)
+                    {
+                        y[i] = samples[i];
+                    }
+                    break;
+                }
+            }
+            y += run;
+        }
 
-    G_OBJECT_CLASS (gtk_chart_parent_class)->dispose (object);
+        index += run;
+        n -= run;
+    }
 }
 
-static void chart_draw_line_or_scatter(GtkChart *self,
-                                       GtkSnapshot *snapshot,
-                                       float h,
-                                       float w)
+static void chart_pyramid_free(struct chart_pyramid_t *pyramid)
 {
-    cairo_text_extents_t extents;
-    char value[20];
+    for (unsigned int k = 0; k < pyramid->n_levels; k++)
+    {
+        struct chart_pyramid_level_t *level = &pyramid->levels[k];
+        g_free(level->min);
+        g_free(level->max);
+        g_free(level->block);
+        g_free(level->count);
+    }
+    g_clear_pointer(&pyramid->levels, g_free);
+    pyramid->n_levels = 0;
+}
 
-    // Assume aspect ratio w:h = 2:1
+// Missing samples (NAN) count towards block completeness but not min/max
+static void chart_pyramid_update(struct chart_pyramid_t *pyramid, guint64 seq, double y)
+{
+    for (unsigned int k = 0; k < pyramid->n_levels; k++)
+    {
+        struct chart_pyramid_level_t *level = &pyramid->levels[k];
+        guint64 block = seq >> (CHART_PYRAMID_SHIFT + k);
+        size_t slot = block % level->size;
 
-    // Set up Cairo region
-    cairo_t * cr = gtk_snapshot_append_cairo (snapshot, &GRAPHENE_RECT_INIT(0, 0, w, h));
-    cairo_set_antialias (cr, CAIRO_ANTIALIAS_FAST);
-    cairo_set_tolerance (cr, 1.5);
-    gdk_cairo_set_source_rgba (cr, &self->text_color);
-    cairo_select_font_face (cr, self->font_name, CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+        if (level->count[slot] == 0 || level->block[slot] != block)
+        {
+            // First sample of block, recycle slot
+            level->block[slot] = block;
+            level->min[slot] = INFINITY;
+            level->max[slot] = -INFINITY;
+            level->count[slot] = 0;
+        }
 
-    // Move coordinate system to bottom left
-    cairo_translate(cr, 0, h);
+        if (!isnan(y))
+        {
+            level->min[slot] = MIN(level->min[slot], y);
+            level->max[slot] = MAX(level->max[slot], y);
+        }
+        level->count[slot]++;
+    }
+}
 
-    // Invert y-axis
-    cairo_scale(cr, 1, -1);
+// Reallocate summaries for ring size and rebuild them from stored points
+static void chart_pyramid_rebuild(struct chart_ring_t *ring, unsigned int series)
+{
+    struct chart_pyramid_t *pyramid = &ring->series[series].pyramid;
+    unsigned int n_levels = 0;
 
-    // Draw title
-    double title_font_size = 0.05 * h;  // 5% of total height
-    cairo_set_font_size (cr, title_font_size);
-    cairo_text_extents(cr, self->title, &extents);
-    cairo_move_to (cr, 0.5 * w - extents.width/2, 0.9 * h - extents.height/2);
-    cairo_save(cr);
-    cairo_scale(cr, 1, -1);
-    cairo_show_text (cr, self->title);
-    cairo_restore(cr);
+    chart_pyramid_free(pyramid);
 
-    // Draw x-axis label
-    cairo_set_font_size (cr, 11.0 * (w/650));
-    cairo_text_extents(cr, self->x_label, &extents);
-    cairo_move_to (cr, 0.5 * w - extents.width/2, 0.075 * h);
-    cairo_save(cr);
-    cairo_scale(cr, 1, -1);
-    cairo_show_text (cr, self->x_label);
-    cairo_restore(cr);
+    while (((size_t) 1 << (CHART_PYRAMID_SHIFT + n_levels)) <= ring->size)
+    {
+        n_levels++;
+    }
 
-    // Draw y-axis label
-    cairo_text_extents(cr, self->y_label, &extents);
-    cairo_move_to (cr, 0.035 * w, 0.5 * h - extents.width/2);
-    cairo_save(cr);
-    cairo_rotate(cr, M_PI/2);
-    cairo_scale(cr, 1, -1);
-    cairo_show_text (cr, self->y_label);
-    cairo_restore(cr);
+    if (n_levels == 0)
+    {
+        return;
+    }
 
-    // Draw x-axis
-    gdk_cairo_set_source_rgba (cr, &self->axis_color);
-    cairo_set_line_width (cr, 1);
-    cairo_move_to (cr, 0.1 * w, 0.2 * h);
-    cairo_line_to (cr, 0.9 * w, 0.2 * h);
-    cairo_stroke (cr);
+    pyramid->levels = g_new0(struct chart_pyramid_level_t, n_levels);
+    pyramid->n_levels = n_levels;
 
-    // Draw y-axis
-    cairo_set_line_width (cr, 1);
-    cairo_move_to (cr, 0.1 * w, 0.8 * h);
-    cairo_line_to (cr, 0.1 * w, 0.2 * h);
-    cairo_stroke (cr);
+    for (unsigned int k = 0; k < n_levels; k++)
+    {
+        struct chart_pyramid_level_t *level = &pyramid->levels[k];
+
+        // Enough slots for every block overlapping the ring, including partial ones at both ends
+        level->size = (ring->size >> (CHART_PYRAMID_SHIFT + k)) + 2;
+        level->min = g_new(double, level->size);
+        level->max = g_new(double, level->size);
+        level->block = g_new0(guint64, level->size);
+        level->count = g_new0(size_t, level->size);
+    }
 
-    // Draw x-axis value at 100% mark
-    gdk_cairo_set_source_rgba (cr, &self->text_color);
-    g_snprintf(value, sizeof(value), "%.1f", self->x_max);
-    cairo_set_font_size (cr, 8.0 * (w/650));
-    cairo_text_extents(cr, value, &extents);
-    cairo_move_to (cr, 0.9 * w - extents.width/2, 0.16 * h);
-    cairo_save(cr);
-    cairo_scale(cr, 1, -1);
-    cairo_show_text (cr, value);
-    cairo_restore(cr);
+    guint64 seq = chart_ring_first_seq(ring);
+    for (size_t i = 0; i < ring->count; i++)
+    {
+        chart_pyramid_update(pyramid, seq + i, chart_ring_y(ring, series, chart_ring_slot(ring, i)));
+    }
+}
 
-    // Draw x-axis value at 75% mark
-    g_snprintf(value, sizeof(value), "%.1f", (self->x_max/4) * 3);
-    cairo_set_font_size (cr, 8.0 * (w/650));
-    cairo_text_extents(cr, value, &extents);
-    cairo_move_to (cr, 0.7 * w - extents.width/2, 0.16 * h);
-    cairo_save(cr);
-    cairo_scale(cr, 1, -1);
-    cairo_show_text (cr, value);
-    cairo_restore(cr);
+// Min/max of y over points [start, end) using the largest complete aligned blocks available
+static void chart_ring_minmax(const struct chart_ring_t *ring,
+                              unsigned int series,
+                              size_t start,
+                              size_t end,
+                              double *min,
+                              double *max)
+{
+    const struct chart_pyramid_t *pyramid = &ring->series[series].pyramid;
+    guint64 first_seq = chart_ring_first_seq(ring);
+    size_t i = start;
 
-    // Draw x-axis value at 50% mark
-    g_snprintf(value, sizeof(value), "%.1f", self->x_max/2);
-    cairo_set_font_size (cr, 8.0 * (w/650));
-    cairo_text_extents(cr, value, &extents);
-    cairo_move_to (cr, 0.5 * w - extents.width/2, 0.16 * h);
-    cairo_save(cr);
-    cairo_scale(cr, 1, -1);
-    cairo_show_text (cr, value);
-    cairo_restore(cr);
+    *min = INFINITY;
+    *max = -INFINITY;
 
-    // Draw x-axis value at 25% mark
-    g_snprintf(value, sizeof(value), "%.1f", self->x_max/4);
-    cairo_set_font_size (cr, 8.0 * (w/650));
-    cairo_text_extents(cr, value, &extents);
-    cairo_move_to (cr, 0.3 * w - extents.width/2, 0.16 * h);
-    cairo_save(cr);
-    cairo_scale(cr, 1, -1);
-    cairo_show_text (cr, value);
-    cairo_restore(cr);
+    while (i < end)
+    {
+        guint64 seq = first_seq + i;
+        int k = (int) pyramid->n_levels - 1;
 
-    // Draw x-axis value at 0% mark
-    g_snprintf(value, sizeof(value), "%.1f", self->x_min);
-    cairo_set_font_size (cr, 8.0 * (w/650));
-    cairo_text_extents(cr, "0", &extents);
-    cairo_move_to (cr, 0.1 * w - extents.width/2, 0.16 * h);
-    cairo_save(cr);
-    cairo_scale(cr, 1, -1);
-    cairo_show_text (cr, value);
-    cairo_restore(cr);
+        while (k >= 0)
+        {
+            size_t block_size = (size_t) 1 << (CHART_PYRAMID_SHIFT + k);
+            if ((seq & (block_size - 1)) == 0 && i + block_size <= end)
+            {
+                break;
+            }
+            k--;
+        }
 
-    // Draw y-axis value at 0% mark
-    g_snprintf(value, sizeof(value), "%.1f", self->y_min);
-    cairo_set_font_size (cr, 8.0 * (w/650));
-    cairo_text_extents(cr, value, &extents);
-    cairo_move_to (cr, 0.091 * w - extents.width, 0.191 * h);
-    cairo_save(cr);
-    cairo_scale(cr, 1, -1);
-    cairo_show_text (cr, value);
-    cairo_restore(cr);
+        if (k >= 0)
+        {
+            const struct chart_pyramid_level_t *level = &pyramid->levels[k];
+            size_t block_size = (size_t) 1 << (CHART_PYRAMID_SHIFT + k);
+            guint64 block = seq >> (CHART_PYRAMID_SHIFT + k);
+            size_t slot = block % level->size;
 
-    // Draw y-axis value at 25% mark
-    g_snprintf(value, sizeof(value), "%.1f", self->y_min + (self->y_max - self->y_min) * 0.25);
-    cairo_set_font_size (cr, 8.0 * (w/650));
-    cairo_text_extents(cr, value, &extents);
-    cairo_move_to (cr, 0.091 * w - extents.width, 0.34 * h);
-    cairo_save(cr);
-    cairo_scale(cr, 1, -1);
-    cairo_show_text (cr, value);
-    cairo_restore(cr);
+            if (level->block[slot] == block && level->count[slot] == block_size)
+            {
+                *min = MIN(*min, level->min[slot]);
+                *max = MAX(*max, level->max[slot]);
+                i += block_size;
+                continue;
+            }
+        }
 
-    // Draw y-axis value at 50% mark
-    g_snprintf(value, sizeof(value), "%.1f", self->y_min + (self->y_max - self->y_min) * 0.5);
-    cairo_set_font_size (cr, 8.0 * (w/650));
-    cairo_text_extents(cr, value, &extents);
-    cairo_move_to (cr, 0.091 * w - extents.width, 0.49 * h);
-    cairo_save(cr);
-    cairo_scale(cr, 1, -1);
-    cairo_show_text (cr, value);
-    cairo_restore(cr);
+        // Unaligned edge, scan raw point
+        double y = chart_ring_y(ring, series, chart_ring_slot(ring, i));
+        if (!isnan(y))
+        {
+            *min = MIN(*min, y);
+            *max = MAX(*max, y);
+        }
+        i++;
+    }
+}
 
-    // Draw y-axis value at 75% mark
-    g_snprintf(value, sizeof(value), "%.1f", self->y_min + (self->y_max - self->y_min) * 0.75);
-    cairo_set_font_size (cr, 8.0 * (w/650));
-    cairo_text_extents(cr, value, &extents);
-    cairo_move_to (cr, 0.091 * w - extents.width, 0.64 * h);
-    cairo_save(cr);
-    cairo_scale(cr, 1, -1);
-    cairo_show_text (cr, value);
-    cairo_restore(cr);
+// First index in [start, end) with x >= value, assumes monotonic x
+static size_t chart_ring_lower_bound(const struct chart_ring_t *ring, size_t start, size_t end, double value)
+{
+    while (start < end)
+    {
+        size_t mid = start + (end - start) / 2;
 
-    // Draw y-axis value at 100% mark
-    g_snprintf(value, sizeof(value), "%.1f", self->y_max);
-    cairo_set_font_size (cr, 8.0 * (w/650));
-    cairo_text_extents(cr, value, &extents);
-    cairo_move_to (cr, 0.091 * w - extents.width, 0.79 * h);
-    cairo_save(cr);
-    cairo_scale(cr, 1, -1);
-    cairo_show_text (cr, value);
-    cairo_restore(cr);
+        if (chart_ring_x(ring, chart_ring_slot(ring, mid)) < value)
+        {
+            start = mid + 1;
+        }
+        else
+        {
+            end = mid;
+        }
+    }
 
-    // Draw grid x-line 25%
-    gdk_cairo_set_source_rgba (cr, &self->grid_color);
-    cairo_set_line_width (cr, 1);
-    cairo_move_to (cr, 0.1 * w, 0.35 * h);
-    cairo_line_to (cr, 0.9 * w, 0.35 * h);
-    cairo_stroke (cr);
+    return start;
+}
 
-    // Draw grid x-line 50%
-    cairo_set_line_width (cr, 1);
-    cairo_move_to (cr, 0.1 * w, 0.5 * h);
-    cairo_line_to (cr, 0.9 * w, 0.5 * h);
-    cairo_stroke (cr);
+// First index in [start, end) with x > value, assumes monotonic x
+static size_t chart_ring_upper_bound(const struct chart_ring_t *ring, size_t start, size_t end, double value)
+{
+    while (start < end)
+    {
+        size_t mid = start + (end - start) / 2;
 
-    // Draw grid x-line 75%
-    cairo_set_line_width (cr, 1);
-    cairo_move_to (cr, 0.1 * w, 0.65 * h);
-    cairo_line_to (cr, 0.9 * w, 0.65 * h);
-    cairo_stroke (cr);
+        if (chart_ring_x(ring, chart_ring_slot(ring, mid)) <= value)
+        {
+            start = mid + 1;
+        }
+        else
+        {
+            end = mid;
+        }
+    }
 
-    // Draw grid x-line 100%
-    cairo_set_line_width (cr, 1);
-    cairo_move_to (cr, 0.1 * w, 0.8 * h);
-    cairo_line_to (cr, 0.9 * w, 0.8 * h);
-    cairo_stroke (cr);
+    return start;
+}
 
-    // Draw grid y-line 25%
-    cairo_set_line_width (cr, 1);
-    cairo_move_to (cr, 0.3 * w, 0.8 * h);
-    cairo_line_to (cr, 0.3 * w, 0.2 * h);
-    cairo_stroke (cr);
+static inline guint64 chart_double_bits(double value)
+{
+    guint64 bits;
 
-    // Draw grid y-line 50%
-    cairo_set_line_width (cr, 1);
-    cairo_move_to (cr, 0.5 * w, 0.8 * h);
-    cairo_line_to (cr, 0.5 * w, 0.2 * h);
-    cairo_stroke (cr);
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
 
-    // Draw grid y-line 75%
-    cairo_set_line_width (cr, 1);
-    cairo_move_to (cr, 0.7 * w, 0.8 * h);
-    cairo_line_to (cr, 0.7 * w, 0.2 * h);
-    cairo_stroke (cr);
+static inline double chart_bits_double(guint64 bits)
+{
+    double value;
 
-    // Draw grid y-line 100%
-    cairo_set_line_width (cr, 1);
-    cairo_move_to (cr, 0.9 * w, 0.8 * h);
-    cairo_line_to (cr, 0.9 * w, 0.2 * h);
-    cairo_stroke (cr);
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
 
-    // Move coordinate system to (0,0) of drawn coordinate system
-    cairo_translate(cr, 0.1 * w, 0.2 * h);
-    gdk_cairo_set_source_rgba (cr, &self->line_color);
-    cairo_set_line_width (cr, 2.0);
+// Bit stream of sealed history blocks, most significant bit first
+struct chart_bit_writer_t
+{
+    GByteArray *bytes;
+    guint64 acc;            // Bits not yet flushed to bytes, in the low n_acc bits
+    unsigned int n_acc;
+    size_t n_bits;
+};
 
-    // Calc scales with min values taken into account
-    float x_scale = (w - 2 * 0.1 * w) / (self->x_max - self->x_min);
-    float y_scale = (h - 2 * 0.2 * h) / (self->y_max - self->y_min);
+struct chart_bit_reader_t
+{
+    const guint8 *data;
+    size_t pos;             // Bit position
+};
 
-    // Draw data points from list
-    GSList *l;
-    gboolean last_point_visible = FALSE;
-    double last_x = 0, last_y = 0;
+static void chart_bits_put(struct chart_bit_writer_t *writer, guint64 value, unsigned int n)
+{
+    if (n > 32)
+    {
+        chart_bits_put(writer, value >> 32, n - 32);
+        n = 32;
+    }
+
+    writer->acc = (writer->acc << n) | (value & ((G_GUINT64_CONSTANT(1) << n) - 1));
+    writer->n_acc += n;
+    writer->n_bits += n;
+
+    while (writer->n_acc >= 8)
+    {
+        guint8 byte = (guint8) (writer->acc >> (writer->n_acc - 8));
+
+        g_byte_array_append(writer->bytes, &byte, 1);
+        writer->n_acc -= 8;
+    }
+}
+
+// Read n bits, relies on data being padded by one word past the last bit
+static guint64 chart_bits_get(struct chart_bit_reader_t *reader, unsigned int n)
+{
+    guint64 word;
+
+    if (n > 32)
+    {
+        guint64 high = chart_bits_get(reader, n - 32);
+        return (high << 32) | chart_bits_get(reader, 32);
+    }
 
-    for (l = self->point_list; l != NULL; l = l->next)
+    if (n == 0)
     {
-        struct chart_point_t *point = l->data;
-        gboolean point_in_viewport = (point->x >= self->x_min &&
-                                    point->x <= self->x_max &&
-                                    point->y >= self->y_min &&
-                                    point->y <= self->y_max);
+        return 0;
+    }
+
+    memcpy(&word, reader->data + (reader->pos >> 3), sizeof(word));
+    word = GUINT64_FROM_BE(word) << (reader->pos & 7);
+    reader->pos += n;
+
+    return word >> (64 - n);
+}
+
+// Delta-of-delta classes following the single '0' bit of an unchanged delta
+static const struct
+{
+    guint8 prefix;
+    guint8 prefix_bits;
+    guint8 value_bits;
+} chart_dod_classes[] =
+{
+    { 0x02, 2, 7 },
+    { 0x06, 3, 9 },
+    { 0x0e, 4, 12 },
+    { 0x1e, 5, 32 },
+    { 0x1f, 5, 64 },
+};
 
-        // Adjust coordinates by min values
-        double x_coord = (point->x - self->x_min) * x_scale;
-        double y_coord = (point->y - self->y_min) * y_scale;
+// Encode x as delta-of-delta of the IEEE bit patterns, lossless and about one bit per point for evenly spaced x
+static void chart_history_encode_x(struct chart_bit_writer_t *writer, const double *x, size_t n)
+{
+    guint64 prev = chart_double_bits(x[0]);
+    guint64 delta = 0;
+
+    chart_bits_put(writer, prev, 64);
+
+    for (size_t i = 1; i < n; i++)
+    {
+        guint64 bits = chart_double_bits(x[i]);
+        gint64 dod = (gint64) (bits - prev - delta);
 
-        switch (self->type)
+        delta = bits - prev;
+        prev = bits;
+
+        if (dod == 0)
         {
-            case GTK_CHART_TYPE_LINE:
-                if (point_in_viewport)
-                {
-                    if (!last_point_visible)
-                    {
-                        // Start a new line segment when coming back into view
-                        cairo_move_to(cr, x_coord, y_coord);
-                    }
-                    else
-                    {
-                        // Continue the line if previous point was visible
-                        cairo_line_to(cr, x_coord, y_coord);
-                        cairo_set_line_join(cr, CAIRO_LINE_JOIN_ROUND);
-                        cairo_stroke(cr);
-                        cairo_move_to(cr, x_coord, y_coord);
-                    }
-                    last_point_visible = TRUE;
-                    last_x = x_coord;
-                    last_y = y_coord;
-                }
-                else
-                {
-                    last_point_visible = FALSE;
-                }
-                break;
+            chart_bits_put(writer, 0, 1);
+            continue;
+        }
 
-            case GTK_CHART_TYPE_SCATTER:
-                if (point_in_viewport)
-                {
-                    // Draw point
-                    cairo_set_line_width(cr, 3);
-                    cairo_set_line_cap(cr, CAIRO_LINE_CAP_ROUND);
-                    cairo_move_to(cr, x_coord, y_coord);
-                    cairo_close_path(cr);
-                    cairo_stroke(cr);
-                }
+        for (unsigned int c = 0; c < G_N_ELEMENTS(chart_dod_classes); c++)
+        {
+            unsigned int width = chart_dod_classes[c].value_bits;
+
+            if (width == 64 || (dod >= -((gint64) 1 << (width - 1)) && dod < ((gint64) 1 << (width - 1))))
+            {
+                chart_bits_put(writer, chart_dod_classes[c].prefix, chart_dod_classes[c].prefix_bits);
+                chart_bits_put(writer, (guint64) dod, width);
                 break;
+            }
         }
     }
+}
+
+static void chart_history_decode_x(const struct chart_history_block_t *block, double *x)
+{
+    struct chart_bit_reader_t reader = { block->data, 0 };
+    guint64 prev = chart_bits_get(&reader, 64);
+    guint64 delta = 0;
+
+    x[0] = chart_bits_double(prev);
+
+    for (size_t i = 1; i < block->count; i++)
+    {
+        unsigned int ones = 0;
+
+        while (ones < G_N_ELEMENTS(chart_dod_classes) && chart_bits_get(&reader, 1))
+        {
+            ones++;
+        }
+
+        if (ones > 0)
+        {
+            unsigned int width = chart_dod_classes[ones - 1].value_bits;
+            guint64 dod = chart_bits_get(&reader, width);
+
+            // Sign extend
+            if (width < 64)
+            {
+                dod = (guint64) ((gint64) (dod << (64 - width)) >> (64 - width));
+            }
+            delta += dod;
+        }
 
-    cairo_destroy (cr);
+        prev += delta;
+        x[i] = chart_bits_double(prev);
+    }
 }
 
-static void chart_draw_number(GtkChart *self,
-                              GtkSnapshot *snapshot,
-                              float h,
-                              float w)
+// Encode samples XORed with their predecessor, storing only the bits between leading and
+// trailing zeros and reusing the previous window while the changed bits fit into it
+static void chart_history_encode_y(struct chart_bit_writer_t *writer, const double *y, size_t n)
 {
-    cairo_text_extents_t extents;
-    char value[20];
+    guint64 prev = chart_double_bits(y[0]);
+    unsigned int lead = 64;
+    unsigned int trail = 64;
 
-    // Assume aspect ratio w:h = 1:1
+    chart_bits_put(writer, prev, 64);
 
-    // Set up Cairo region
-    cairo_t * cr = gtk_snapshot_append_cairo (snapshot, &GRAPHENE_RECT_INIT(0, 0, w, h));
-    cairo_set_antialias (cr, CAIRO_ANTIALIAS_FAST);
-    cairo_set_tolerance (cr, 1.5);
-    gdk_cairo_set_source_rgba (cr, &self->text_color);
-    cairo_select_font_face (cr, self->font_name, CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+    for (size_t i = 1; i < n; i++)
+    {
+        guint64 bits = chart_double_bits(y[i]);
+        guint64 xor = bits ^ prev;
+
+        prev = bits;
+
+        if (xor == 0)
+        {
+            chart_bits_put(writer, 0, 1);
+            continue;
+        }
+
+        unsigned int xor_lead = MIN((unsigned int) __builtin_clzll(xor), 31);
+        unsigned int xor_trail = (unsigned int) __builtin_ctzll(xor);
+
+        if (xor_lead >= lead && xor_trail >= trail)
+        {
+            chart_bits_put(writer, 0x2, 2);
+        }
+        else
+        {
+            // New window, a length of 64 is stored as 0
+            lead = xor_lead;
+            trail = xor_trail;
+            chart_bits_put(writer, 0x3, 2);
+            chart_bits_put(writer, lead, 5);
+            chart_bits_put(writer, 64 - lead - trail, 6);
+        }
+        chart_bits_put(writer, xor >> trail, 64 - lead - trail);
+    }
+}
+
+static void chart_history_decode_y(const struct chart_history_block_t *block, unsigned int series, double *y)
+{
+    struct chart_bit_reader_t reader = { block->data, block->columns[series].offset };
+    guint64 prev = chart_bits_get(&reader, 64);
+    unsigned int lead = 0;
+    unsigned int trail = 0;
+
+    y[0] = chart_bits_double(prev);
+
+    for (size_t i = 1; i < block->count; i++)
+    {
+        if (chart_bits_get(&reader, 1))
+        {
+            if (chart_bits_get(&reader, 1))
+            {
+                unsigned int length;
+
+                lead = (unsigned int) chart_bits_get(&reader, 5);
+                length = (unsigned int) chart_bits_get(&reader, 6);
+                trail = 64 - lead - (length ? length : 64);
+            }
+            prev ^= chart_bits_get(&reader, 64 - lead - trail) << trail;
+        }
+        y[i] = chart_bits_double(prev);
+    }
+}
+
+static inline size_t chart_history_n_blocks(const struct chart_history_t *history)
+{
+    size_t n = (history->blocks != NULL) ? history->blocks->len - history->first : 0;
+
+    return n + (history->open != NULL ? 1 : 0);
+}
+
+// Block by age (0 = oldest), the open block comes last
+static inline const struct chart_history_block_t * chart_history_block(const struct chart_history_t *history, size_t index)
+{
+    size_t n_sealed = (history->blocks != NULL) ? history->blocks->len - history->first : 0;
+
+    return (index < n_sealed) ? g_ptr_array_index(history->blocks, history->first + index) : history->open;
+}
+
+static inline size_t chart_history_block_size(const struct chart_history_block_t *block)
+{
+    return sizeof(*block) + block->n_series * sizeof(block->columns[0]) + block->n_bytes;
+}
+
+// Fill x and y of series with points of block, either array may be NULL
+static void chart_history_read(const struct chart_history_t *history,
+                               const struct chart_history_block_t *block,
+                               unsigned int series,
+                               double *x,
+                               double *y)
+{
+    if (x != NULL)
+    {
+        if (block == history->open)
+        {
+            memcpy(x, history->open_x, block->count * sizeof(double));
+        }
+        else
+        {
+            chart_history_decode_x(block, x);
+        }
+    }
+
+    if (y != NULL)
+    {
+        if (series >= block->n_series)
+        {
+            // Series was added after block
+            for (size_t i = 0; i < block->count; i++)
+            {
+                y[i] = NAN;
+            }
+        }
+        else if (block == history->open)
+        {
+            memcpy(y, &history->open_y[series * CHART_HISTORY_BLOCK], block->count * sizeof(double));
+        }
+        else
+        {
+            chart_history_decode_y(block, series, y);
+        }
+    }
+}
+
+static struct chart_history_block_t * chart_history_block_new(unsigned int n_series)
+{
+    struct chart_history_block_t *block = g_malloc0(sizeof(*block) + n_series * sizeof(block->columns[0]));
+
+    block->n_series = n_series;
+    block->x_min = INFINITY;
+    block->x_max = -INFINITY;
+    for (unsigned int s = 0; s < n_series; s++)
+    {
+        block->columns[s].min = INFINITY;
+        block->columns[s].max = -INFINITY;
+    }
+
+    return block;
+}
+
+static void chart_history_block_free(struct chart_history_block_t *block)
+{
+    g_free(block->data);
+    g_free(block);
+}
+
+// Drop oldest sealed blocks while the remaining points still fill capacity
+static void chart_history_trim(struct chart_history_t *history)
+{
+    size_t n_open = history->open ? history->open->count : 0;
+
+    while (history->first < history->blocks->len)
+    {
+        struct chart_history_block_t *block = g_ptr_array_index(history->blocks, history->first);
+
+        if (history->count - block->count + n_open < history->capacity)
+        {
+            break;
+        }
+
+        history->count -= block->count;
+        history->bytes -= chart_history_block_size(block);
+        chart_history_block_free(block);
+        history->first++;
+    }
+
+    // Compact array once half of it is dropped blocks
+    if (history->first > 0 && history->first >= history->blocks->len / 2)
+    {
+        g_ptr_array_remove_range(history->blocks, 0, history->first);
+        history->first = 0;
+    }
+}
+
+// Compress open block and append it to the sealed blocks
+static void chart_history_seal(struct chart_history_t *history)
+{
+    static const guint8 padding[8] = { 0 };
+    struct chart_history_block_t *block = history->open;
+    struct chart_bit_writer_t writer = { g_byte_array_new(), 0, 0, 0 };
+
+    chart_history_encode_x(&writer, history->open_x, block->count);
+    for (unsigned int s = 0; s < block->n_series; s++)
+    {
+        block->columns[s].offset = writer.n_bits;
+        chart_history_encode_y(&writer, &history->open_y[s * CHART_HISTORY_BLOCK], block->count);
+    }
+
+    // Complete last byte and add a word so the reader can always load 64 bits
+    chart_bits_put(&writer, 0, (8 - writer.n_acc) % 8);
+    g_byte_array_append(writer.bytes, padding, sizeof(padding));
+
+    block->n_bytes = writer.bytes->len;
+    block->data = g_byte_array_free(writer.bytes, FALSE);
+
+    g_ptr_array_add(history->blocks, block);
+    history->count += block->count;
+    history->bytes += chart_history_block_size(block);
+    history->open = NULL;
+
+    chart_history_trim(history);
+}
+
+// Add point to open block, series from n_ys onwards get no sample
+static void chart_history_append(struct chart_history_t *history,
+                                 double x,
+                                 const double *ys,
+                                 unsigned int n_ys,
+                                 unsigned int n_series)
+{
+    // Series added since block was opened start a new block
+    if (history->open != NULL && history->open->n_series != n_series)
+    {
+        chart_history_seal(history);
+    }
+
+    if (history->open == NULL)
+    {
+        history->open = chart_history_block_new(n_series);
+        history->open_y = g_renew(double, history->open_y, (size_t) MAX(n_series, 1) * CHART_HISTORY_BLOCK);
+    }
+
+    struct chart_history_block_t *block = history->open;
+    size_t i = block->count++;
+
+    if (i == 0)
+    {
+        block->x_first = x;
+    }
+    block->x_last = x;
+    block->x_min = MIN(block->x_min, x);
+    block->x_max = MAX(block->x_max, x);
+    history->open_x[i] = x;
+
+    for (unsigned int s = 0; s < n_series; s++)
+    {
+        struct chart_history_column_t *column = &block->columns[s];
+        double y = (s < n_ys) ? ys[s] : NAN;
+
+        history->open_y[s * CHART_HISTORY_BLOCK + i] = y;
+        if (i == 0)
+        {
+            column->first = y;
+        }
+        column->last = y;
+
+        if (isnan(y))
+        {
+            column->gaps = TRUE;
+        }
+        else
+        {
+            column->min = MIN(column->min, y);
+            column->max = MAX(column->max, y);
+        }
+    }
+
+    if (block->count == CHART_HISTORY_BLOCK)
+    {
+        chart_history_seal(history);
+    }
+}
+
+static void chart_history_free(struct chart_history_t *history)
+{
+    if (history->blocks != NULL)
+    {
+        for (guint i = history->first; i < history->blocks->len; i++)
+        {
+            chart_history_block_free(g_ptr_array_index(history->blocks, i));
+        }
+        g_ptr_array_free(history->blocks, TRUE);
+    }
+
+    g_clear_pointer(&history->open, chart_history_block_free);
+    g_free(history->open_x);
+    g_free(history->open_y);
+    memset(history, 0, sizeof(*history));
+}
+
+// Keep up to capacity points evicted from the ring, 0 discards the history
+static void chart_history_set_capacity(struct chart_history_t *history, size_t capacity)
+{
+    if (capacity == 0)
+    {
+        chart_history_free(history);
+        return;
+    }
+
+    if (history->blocks == NULL)
+    {
+        history->blocks = g_ptr_array_new();
+        history->open_x = g_new(double, CHART_HISTORY_BLOCK);
+    }
+
+    history->capacity = capacity;
+    chart_history_trim(history);
+}
+
+// Move n oldest points of ring into history before they are overwritten or dropped
+static void chart_ring_archive(struct chart_ring_t *ring, size_t n)
+{
+    if (ring->history.capacity == 0)
+    {
+        return;
+    }
+
+    double *ys = g_newa(double, MAX(ring->n_series, 1));
+
+    for (size_t i = 0; i < n; i++)
+    {
+        size_t slot = chart_ring_slot(ring, i);
+
+        for (unsigned int s = 0; s < ring->n_series; s++)
+        {
+            ys[s] = chart_ring_y(ring, s, slot);
+        }
+        chart_history_append(&ring->history, chart_ring_x(ring, slot), ys, ring->n_series, ring->n_series);
+    }
+}
+
+// Recompute x of points kept in history from their sequence numbers, after the uniform x grid changed
+static void chart_ring_rebase_history(struct chart_ring_t *ring)
+{
+    struct chart_history_t old = ring->history;
+    guint64 seq = chart_ring_oldest_seq(ring);
+
+    if (old.capacity == 0)
+    {
+        return;
+    }
+
+    double *columns = g_new(double, (size_t) MAX(ring->n_series, 1) * CHART_HISTORY_BLOCK);
+    double *row = g_newa(double, MAX(ring->n_series, 1));
+
+    memset(&ring->history, 0, sizeof(ring->history));
+    chart_history_set_capacity(&ring->history, old.capacity);
+
+    for (size_t b = 0; b < chart_history_n_blocks(&old); b++)
+    {
+        const struct chart_history_block_t *block = chart_history_block(&old, b);
+
+        for (unsigned int s = 0; s < block->n_series; s++)
+        {
+            chart_history_read(&old, block, s, NULL, &columns[s * CHART_HISTORY_BLOCK]);
+        }
+
+        for (size_t i = 0; i < block->count; i++)
+        {
+            for (unsigned int s = 0; s < block->n_series; s++)
+            {
+                row[s] = columns[s * CHART_HISTORY_BLOCK + i];
+            }
+            chart_history_append(&ring->history, chart_ring_uniform_x(ring, seq++), row,
+                                 block->n_series, block->n_series);
+        }
+    }
+
+    chart_history_free(&old);
+    g_free(columns);
+}
+
+// Copy count samples of element size starting at logical index first into new linear array of size slots
+static void * chart_ring_linearize(const struct chart_ring_t *ring,
+                                   const void *data,
+                                   size_t element,
+                                   size_t first,
+                                   size_t count,
+                                   size_t size)
+{
+    guint8 *linear = g_malloc(element * size);
+
+    if (count > 0)
+    {
+        size_t slot = chart_ring_slot(ring, first);
+        size_t part = MIN(count, ring->size - slot);
+
+        memcpy(linear, (const guint8 *) data + slot * element, part * element);
+        memcpy(linear + part * element, data, (count - part) * element);
+    }
+
+    return linear;
+}
+
+// Reallocate ring to exactly size slots, keeping the newest points in order
+static void chart_ring_resize(struct chart_ring_t *ring, size_t size)
+{
+    size_t keep = MIN(ring->count, size);
+    size_t first = ring->count - keep;
+    size_t x_size = chart_storage_x_size(ring->storage);
+    size_t y_size = chart_storage_y_size(ring->storage);
+
+    chart_ring_archive(ring, first);
+
+    if (x_size > 0)
+    {
+        void *x = chart_ring_linearize(ring, ring->x, x_size, first, keep, size);
+        g_free(ring->x);
+        ring->x = x;
+    }
+
+    for (unsigned int s = 0; s < ring->n_series; s++)
+    {
+        void *y = chart_ring_linearize(ring, ring->series[s].y, y_size, first, keep, size);
+        g_free(ring->series[s].y);
+        ring->series[s].y = y;
+    }
+
+    ring->size = size;
+    ring->head = 0;
+    ring->count = keep;
+
+    for (unsigned int s = 0; s < ring->n_series; s++)
+    {
+        chart_pyramid_rebuild(ring, s);
+    }
+}
+
+// Add series without samples for the points already stored, returns its index
+static unsigned int chart_ring_add_series(struct chart_ring_t *ring)
+{
+    unsigned int s = ring->n_series++;
+
+    ring->series = g_renew(struct chart_ring_series_t, ring->series, ring->n_series);
+    memset(&ring->series[s], 0, sizeof(ring->series[s]));
+
+    if (ring->size > 0)
+    {
+        ring->series[s].y = g_malloc(ring->size * chart_storage_y_size(ring->storage));
+        for (size_t i = 0; i < ring->size; i++)
+        {
+            chart_ring_set_y(ring, s, i, NAN);
+        }
+        chart_pyramid_rebuild(ring, s);
+    }
+
+    return s;
+}
+
+// Make room for n more points, growing geometrically until the capacity limit is reached
+static void chart_ring_reserve(struct chart_ring_t *ring, size_t n)
+{
+    size_t needed = ring->count + n;
+
+    if (ring->capacity != 0)
+    {
+        needed = MIN(needed, ring->capacity);
+    }
+
+    if (needed <= ring->size)
+    {
+        return;
+    }
+
+    size_t size = MAX(ring->size * 2, CHART_RING_MIN_SIZE);
+    while (size < needed)
+    {
+        size *= 2;
+    }
+    if (ring->capacity != 0)
+    {
+        size = MIN(size, ring->capacity);
+    }
+
+    chart_ring_resize(ring, size);
+}
+
+// Update x order tracking for point with sequence number seq, given x of its predecessor
+static inline void chart_ring_index_point(struct chart_ring_t *ring,
+                                          guint64 seq,
+                                          double prev_x,
+                                          double x)
+{
+    if (seq > 0 && x < prev_x)
+    {
+        ring->disorder = seq;
+    }
+}
+
+// Append point with one y per series, series from n_ys onwards get no sample
+static void chart_ring_push(struct chart_ring_t *ring, double x, const double *ys, unsigned int n_ys)
+{
+    chart_ring_reserve(ring, 1);
+
+    size_t slot;
+
+    if (!chart_storage_is_uniform(ring->storage))
+    {
+        double prev_x = (ring->count > 0) ? chart_ring_x(ring, chart_ring_slot(ring, ring->count - 1)) : x;
+        chart_ring_index_point(ring, ring->total, prev_x, x);
+    }
+
+    if (ring->count == ring->size)
+    {
+        // Full, overwrite oldest point
+        chart_ring_archive(ring, 1);
+        slot = ring->head;
+        ring->head = (ring->head + 1 == ring->size) ? 0 : ring->head + 1;
+    }
+    else
+    {
+        slot = chart_ring_slot(ring, ring->count);
+        ring->count++;
+    }
+
+    chart_ring_set_x(ring, slot, x);
+    for (unsigned int s = 0; s < ring->n_series; s++)
+    {
+        chart_ring_set_y(ring, s, slot, (s < n_ys) ? ys[s] : NAN);
+
+        // Summarize stored value, which may be rounded
+        chart_pyramid_update(&ring->series[s].pyramid, ring->total, chart_ring_y(ring, s, slot));
+    }
+    ring->total++;
+}
+
+// Append block of points, ys holds one array per series for the first n_ys series.
+// Double storage copies with at most two memcpy() per array.
+static void chart_ring_push_block(struct chart_ring_t *ring,
+                                  const double *x,
+                                  const double * const *ys,
+                                  unsigned int n_ys,
+                                  size_t n)
+{
+    chart_ring_reserve(ring, n);
+
+    gboolean uniform = chart_storage_is_uniform(ring->storage);
+    double prev_x = (ring->count > 0 && !uniform) ? chart_ring_x(ring, chart_ring_slot(ring, ring->count - 1)) : x[0];
+    size_t skip = 0;
+
+    // Points pushed out of the ring, oldest first
+    if (ring->count + n > ring->size)
+    {
+        chart_ring_archive(ring, MIN(ring->count, ring->count + n - ring->size));
+    }
+
+    // Only the newest points of an oversized block survive
+    if (n > ring->size)
+    {
+        skip = n - ring->size;
+
+        if (ring->history.capacity > 0)
+        {
+            double *row = g_newa(double, MAX(ring->n_series, 1));
+
+            for (size_t i = 0; i < skip; i++)
+            {
+                // Store as the ring would have
+                double point_x = uniform ? chart_ring_uniform_x(ring, ring->total + i) : chart_ring_stored_x(ring, x[i]);
+
+                for (unsigned int s = 0; s < ring->n_series; s++)
+                {
+                    row[s] = (s < n_ys) ? chart_ring_stored_y(ring, ys[s][i]) : NAN;
+                }
+                chart_history_append(&ring->history, point_x, row, ring->n_series, ring->n_series);
+            }
+        }
+
+        prev_x = x[skip - 1];
+        x += skip;
+        n = ring->size;
+        ring->total += skip;
+    }
+
+    if (n == 0)
+    {
+        return;
+    }
+
+    if (!uniform)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            chart_ring_index_point(ring, ring->total + i, (i > 0) ? x[i - 1] : prev_x, x[i]);
+        }
+    }
+
+    size_t tail = chart_ring_slot(ring, ring->count);
+    size_t first = MIN(n, ring->size - tail);
+
+    if (ring->storage == GTK_CHART_STORAGE_DOUBLE)
+    {
+        memcpy((double *) ring->x + tail, x, first * sizeof(double));
+        memcpy(ring->x, &x[first], (n - first) * sizeof(double));
+    }
+    else
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            chart_ring_set_x(ring, (tail + i) % ring->size, x[i]);
+        }
+    }
+
+    for (unsigned int s = 0; s < ring->n_series; s++)
+    {
+        struct chart_ring_series_t *series = &ring->series[s];
+        const double *y = (s < n_ys) ? ys[s] + skip : NULL;
+
+        if (y != NULL && ring->storage == GTK_CHART_STORAGE_DOUBLE)
+        {
+            memcpy((double *) series->y + tail, y, first * sizeof(double));
+            memcpy(series->y, &y[first], (n - first) * sizeof(double));
+            for (size_t i = 0; i < n; i++)
+            {
+                chart_pyramid_update(&series->pyramid, ring->total + i, y[i]);
+            }
+            continue;
+        }
+
+        for (size_t i = 0; i < n; i++)
+        {
+            size_t slot = (tail + i) % ring->size;
+
+            chart_ring_set_y(ring, s, slot, y ? y[i] : NAN);
+            chart_pyramid_update(&series->pyramid, ring->total + i, chart_ring_y(ring, s, slot));
+        }
+    }
+    ring->total += n;
+
+    size_t total = ring->count + n;
+    if (total > ring->size)
+    {
+        // Oldest points were overwritten
+        ring->head = chart_ring_slot(ring, total - ring->size);
+        ring->count = ring->size;
+    }
+    else
+    {
+        ring->count = total;
+    }
+}
+
+// Append a block of points read with element strides, e.g. interleaved x/y pairs.
+// Points are gathered into contiguous blocks, so eviction and history match chart_ring_push_block().
+static void chart_ring_push_strided(struct chart_ring_t *ring,
+                                    const double *x, size_t x_stride,
+                                    const double *y, size_t y_stride,
+                                    size_t n)
+{
+    double *xs = g_new(double, 2 * CHART_HISTORY_BLOCK);
+    const double *ys = &xs[CHART_HISTORY_BLOCK];
+
+    for (size_t i = 0; i < n; i += CHART_HISTORY_BLOCK)
+    {
+        size_t m = MIN(n - i, CHART_HISTORY_BLOCK);
+
+        for (size_t k = 0; k < m; k++)
+        {
+            xs[k] = x[(i + k) * x_stride];
+            xs[CHART_HISTORY_BLOCK + k] = y[(i + k) * y_stride];
+        }
+        chart_ring_push_block(ring, xs, &ys, 1, m);
+    }
+
+    g_free(xs);
+}
+
+// Re-encode stored points in new storage format and int16 scale, switching to uniform x drops stored x
+static void chart_ring_convert(struct chart_ring_t *ring, GtkChartStorage storage, double y_offset, double y_step)
+{
+    struct chart_ring_t old = *ring;
+    size_t x_size = chart_storage_x_size(storage);
+    size_t y_size = chart_storage_y_size(storage);
+
+    ring->storage = storage;
+    ring->y_offset = y_offset;
+    ring->y_step = y_step;
+    ring->x = (x_size > 0 && ring->size > 0) ? g_malloc(ring->size * x_size) : NULL;
+    ring->series = g_new0(struct chart_ring_series_t, ring->n_series);
+
+    for (unsigned int s = 0; s < ring->n_series; s++)
+    {
+        ring->series[s].y = (ring->size > 0) ? g_malloc(ring->size * y_size) : NULL;
+        ring->series[s].pyramid = old.series[s].pyramid;
+    }
+
+    for (size_t i = 0; i < ring->count; i++)
+    {
+        size_t slot = chart_ring_slot(ring, i);
+
+        chart_ring_set_x(ring, slot, chart_ring_x(&old, slot));
+        for (unsigned int s = 0; s < ring->n_series; s++)
+        {
+            chart_ring_set_y(ring, s, slot, chart_ring_y(&old, s, slot));
+        }
+    }
+
+    g_free(old.x);
+    for (unsigned int s = 0; s < ring->n_series; s++)
+    {
+        g_free(old.series[s].y);
+        chart_pyramid_rebuild(ring, s);
+    }
+    g_free(old.series);
+
+    if (chart_storage_is_uniform(storage))
+    {
+        ring->disorder = 0;
+    }
+}
+
+static void chart_ring_free(struct chart_ring_t *ring)
+{
+    chart_history_free(&ring->history);
+    g_clear_pointer(&ring->x, g_free);
+    for (unsigned int s = 0; s < ring->n_series; s++)
+    {
+        g_free(ring->series[s].y);
+        chart_pyramid_free(&ring->series[s].pyramid);
+    }
+    g_clear_pointer(&ring->series, g_free);
+    ring->n_series = 0;
+    ring->size = 0;
+    ring->head = 0;
+    ring->count = 0;
+}
+
+static struct chart_history_block_t * chart_history_block_copy(const struct chart_history_block_t *block)
+{
+    struct chart_history_block_t *copy = g_memdup2(block, sizeof(*block) + block->n_series * sizeof(block->columns[0]));
+
+    copy->data = g_memdup2(block->data, block->n_bytes);
+
+    return copy;
+}
+
+// Deep copy of history, for drawing outside of the main thread
+static void chart_history_copy(struct chart_history_t *dest, const struct chart_history_t *src)
+{
+    *dest = *src;
+    dest->blocks = NULL;
+    dest->first = 0;
+    dest->open = NULL;
+    dest->open_x = NULL;
+    dest->open_y = NULL;
+
+    if (src->blocks != NULL)
+    {
+        dest->blocks = g_ptr_array_sized_new(src->blocks->len - src->first);
+        for (guint i = src->first; i < src->blocks->len; i++)
+        {
+            g_ptr_array_add(dest->blocks, chart_history_block_copy(g_ptr_array_index(src->blocks, i)));
+        }
+        dest->open_x = g_memdup2(src->open_x, CHART_HISTORY_BLOCK * sizeof(double));
+    }
+
+    if (src->open != NULL)
+    {
+        dest->open = chart_history_block_copy(src->open);
+        dest->open_y = g_memdup2(src->open_y, (size_t) MAX(src->open->n_series, 1) * CHART_HISTORY_BLOCK * sizeof(double));
+    }
+}
+
+// Deep copy of ring with its summaries and history, for drawing outside of the main thread
+static void chart_ring_copy(struct chart_ring_t *dest, const struct chart_ring_t *src)
+{
+    size_t x_size = chart_storage_x_size(src->storage);
+    size_t y_size = chart_storage_y_size(src->storage);
+
+    *dest = *src;
+    dest->x = (src->x != NULL) ? g_memdup2(src->x, src->size * x_size) : NULL;
+    dest->series = g_new0(struct chart_ring_series_t, MAX(src->n_series, 1));
+
+    for (unsigned int s = 0; s < src->n_series; s++)
+    {
+        const struct chart_pyramid_t *pyramid = &src->series[s].pyramid;
+        struct chart_pyramid_t *copy = &dest->series[s].pyramid;
+
+        dest->series[s].y = g_memdup2(src->series[s].y, src->size * y_size);
+        copy->n_levels = pyramid->n_levels;
+        copy->levels = g_new0(struct chart_pyramid_level_t, MAX(pyramid->n_levels, 1));
+        for (unsigned int k = 0; k < pyramid->n_levels; k++)
+        {
+            const struct chart_pyramid_level_t *level = &pyramid->levels[k];
+
+            copy->levels[k].size = level->size;
+            copy->levels[k].min = g_memdup2(level->min, level->size * sizeof(double));
+            copy->levels[k].max = g_memdup2(level->max, level->size * sizeof(double));
+            copy->levels[k].block = g_memdup2(level->block, level->size * sizeof(guint64));
+            copy->levels[k].count = g_memdup2(level->count, level->size * sizeof(size_t));
+        }
+    }
+
+    chart_history_copy(&dest->history, &src->history);
+}
+
+// Convert samples between little-endian file order and host order in place
+static void chart_storage_swap_le(void *data, size_t element, size_t n)
+{
+#if G_BYTE_ORDER == G_BIG_ENDIAN
+    for (size_t i = 0; i < n; i++)
+    {
+        switch (element)
+        {
+            case sizeof(guint64):
+                ((guint64 *) data)[i] = GUINT64_SWAP_LE_BE(((guint64 *) data)[i]);
+                break;
+            case sizeof(guint32):
+                ((guint32 *) data)[i] = GUINT32_SWAP_LE_BE(((guint32 *) data)[i]);
+                break;
+            default:
+                ((guint16 *) data)[i] = GUINT16_SWAP_LE_BE(((guint16 *) data)[i]);
+                break;
+        }
+    }
+#else
+    UNUSED(data);
+    UNUSED(element);
+    UNUSED(n);
+#endif
+}
+
+// Replace stored points with count points given as little-endian columns in storage format, ys holds
+// the first n_ys series. The newest points are copied into the ring, older ones pass through it into history.
+static void chart_ring_assign(struct chart_ring_t *ring,
+                              GtkChartStorage storage,
+                              const guint8 *x,
+                              const guint8 * const *ys,
+                              unsigned int n_ys,
+                              size_t count)
+{
+    size_t history_capacity = ring->history.capacity;
+    size_t x_size = chart_storage_x_size(storage);
+    size_t y_size = chart_storage_y_size(storage);
+
+    chart_history_free(&ring->history);
+    chart_history_set_capacity(&ring->history, history_capacity);
+
+    // Storage is reallocated in the new format
+    g_clear_pointer(&ring->x, g_free);
+    for (unsigned int s = 0; s < ring->n_series; s++)
+    {
+        g_clear_pointer(&ring->series[s].y, g_free);
+    }
+    ring->storage = storage;
+    ring->size = 0;
+    ring->head = 0;
+    ring->count = 0;
+    ring->total = 0;
+    ring->disorder = 0;
+    chart_ring_reserve(ring, count);
+
+    size_t keep = MIN(count, ring->size);
+    size_t start = count - keep;
+    size_t first = start - MIN(start, history_capacity);
+    size_t pos = first;
+    double prev_x = 0;
+
+    while (pos < count)
+    {
+        size_t n = (pos < start) ? MIN(ring->size, start - pos) : keep;
+
+        if (x_size > 0)
+        {
+            memcpy(ring->x, x + pos * x_size, n * x_size);
+            chart_storage_swap_le(ring->x, x_size, n);
+
+            for (size_t i = 0; i < n; i++)
+            {
+                double point_x = chart_ring_x(ring, i);
+
+                chart_ring_index_point(ring, pos + i, (pos + i > first) ? prev_x : point_x, point_x);
+                prev_x = point_x;
+            }
+        }
+
+        for (unsigned int s = 0; s < ring->n_series; s++)
+        {
+            if (s < n_ys)
+            {
+                memcpy(ring->series[s].y, ys[s] + pos * y_size, n * y_size);
+                chart_storage_swap_le(ring->series[s].y, y_size, n);
+            }
+            else
+            {
+                for (size_t i = 0; i < n; i++)
+                {
+                    chart_ring_set_y(ring, s, i, NAN);
+                }
+            }
+        }
+
+        ring->count = n;
+        ring->total = pos + n;
+        if (pos < start)
+        {
+            chart_ring_archive(ring, n);
+        }
+        pos += n;
+    }
+
+    for (unsigned int s = 0; s < ring->n_series; s++)
+    {
+        chart_pyramid_rebuild(ring, s);
+    }
+}
+
+// Column 0 is x, column s + 1 is y of series s
+static inline double chart_mapped_value(const struct chart_mapped_t *mapped, size_t index, unsigned int column)
+{
+    guint64 bits;
+
+    memcpy(&bits, mapped->records + index * mapped->stride + column * sizeof(double), sizeof(bits));
+    return chart_bits_double(GUINT64_FROM_LE(bits));
+}
+
+// First record in [start, end) with x >= value, or x > value if after is set
+static size_t chart_mapped_search(const struct chart_mapped_t *mapped, size_t start, size_t end, double value, gboolean after)
+{
+    while (start < end)
+    {
+        size_t mid = start + (end - start) / 2;
+        double x = chart_mapped_value(mapped, mid, 0);
+
+        if (x < value || (after && x == value))
+        {
+            start = mid + 1;
+        }
+        else
+        {
+            end = mid;
+        }
+    }
+
+    return start;
+}
+
+// Summarize records block by block, one sequential pass over the file
+static void chart_mapped_summarize(struct chart_mapped_t *mapped)
+{
+    mapped->n_blocks = (mapped->count + CHART_MAPPED_BLOCK - 1) / CHART_MAPPED_BLOCK;
+    mapped->blocks = g_new(struct chart_mapped_block_t, MAX(mapped->n_blocks, 1));
+    mapped->columns = g_new(struct chart_mapped_column_t, MAX(mapped->n_blocks * mapped->n_series, 1));
+
+    for (size_t b = 0; b < mapped->n_blocks; b++)
+    {
+        size_t first = b * CHART_MAPPED_BLOCK;
+        size_t last = MIN(first + CHART_MAPPED_BLOCK, mapped->count) - 1;
+
+        mapped->blocks[b].x_first = chart_mapped_value(mapped, first, 0);
+        mapped->blocks[b].x_last = chart_mapped_value(mapped, last, 0);
+
+        for (unsigned int s = 0; s < mapped->n_series; s++)
+        {
+            struct chart_mapped_column_t *column = &mapped->columns[b * mapped->n_series + s];
+
+            column->first = chart_mapped_value(mapped, first, s + 1);
+            column->last = chart_mapped_value(mapped, last, s + 1);
+            column->min = INFINITY;
+            column->max = -INFINITY;
+            column->gaps = FALSE;
+        }
+
+        for (size_t i = first; i <= last; i++)
+        {
+            for (unsigned int s = 0; s < mapped->n_series; s++)
+            {
+                struct chart_mapped_column_t *column = &mapped->columns[b * mapped->n_series + s];
+                double y = chart_mapped_value(mapped, i, s + 1);
+
+                if (isnan(y))
+                {
+                    column->gaps = TRUE;
+                }
+                else
+                {
+                    column->min = MIN(column->min, y);
+                    column->max = MAX(column->max, y);
+                }
+            }
+        }
+    }
+}
+
+// Map series file, header is magic, version and number of series as little-endian guint32
+static gboolean chart_mapped_open(struct chart_mapped_t *mapped, const char *path, GError **error)
+{
+    GMappedFile *file = g_mapped_file_new(path, FALSE, error);
+    guint32 version, n_series;
+
+    if (file == NULL)
+    {
+        return FALSE;
+    }
+
+    const guint8 *data = (const guint8 *) g_mapped_file_get_contents(file);
+    size_t length = g_mapped_file_get_length(file);
+
+    if (length < CHART_MAPPED_HEADER_SIZE || memcmp(data, CHART_MAPPED_MAGIC, 8) != 0)
+    {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "%s: Not a chart series file", path);
+        g_mapped_file_unref(file);
+        return FALSE;
+    }
+
+    memcpy(&version, data + 8, sizeof(version));
+    memcpy(&n_series, data + 12, sizeof(n_series));
+    version = GUINT32_FROM_LE(version);
+    n_series = GUINT32_FROM_LE(n_series);
+
+    if (version != CHART_MAPPED_VERSION || n_series == 0 || n_series > CHART_MAPPED_MAX_SERIES)
+    {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "%s: Unsupported chart series file", path);
+        g_mapped_file_unref(file);
+        return FALSE;
+    }
+
+    // Corrupt or truncated header, the file must hold at least one record
+    if (length - CHART_MAPPED_HEADER_SIZE < (1 + (size_t) n_series) * sizeof(double))
+    {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "%s: Truncated chart series file", path);
+        g_mapped_file_unref(file);
+        return FALSE;
+    }
+
+    mapped->file = file;
+    mapped->records = data + CHART_MAPPED_HEADER_SIZE;
+    mapped->n_series = n_series;
+    mapped->stride = (1 + (size_t) n_series) * sizeof(double);
+
+    // Partial record still being written is ignored
+    mapped->count = (length - CHART_MAPPED_HEADER_SIZE) / mapped->stride;
+
+    chart_mapped_summarize(mapped);
+
+    return TRUE;
+}
+
+static void chart_mapped_close(struct chart_mapped_t *mapped)
+{
+    g_clear_pointer(&mapped->file, g_mapped_file_unref);
+    g_free(mapped->blocks);
+    g_free(mapped->columns);
+    memset(mapped, 0, sizeof(*mapped));
+}
+
+static void chart_series_free(gpointer data)
+{
+    struct chart_series_t *series = data;
+
+    g_clear_pointer(&series->marker.surface, cairo_surface_destroy);
+    g_clear_object(&series->marker.texture);
+    g_free(series);
+}
+
+static void gtk_chart_init(GtkChart *self)
+{
+    // Defaults
+    self->state.type = GTK_CHART_TYPE_UNKNOWN;
+    self->state.title = NULL;
+    self->state.label = NULL;
+    self->state.x_label = NULL;
+    self->state.y_label = NULL;
+    self->state.x_max = 100;
+    self->state.y_max = 100;
+    self->state.value_min = 0;
+    self->state.value_max = 100;
+    self->state.width = 500;
+    self->snapshot = NULL;
+    self->state.text_color.alpha = -1.0;
+    self->state.line_color.alpha = -1.0;
+    self->state.grid_color.alpha = -1.0;
+    self->state.axis_color.alpha = -1.0;
+    self->state.font_name = NULL;
+    self->state.ticks = 4;
+    self->dirty = FALSE;
+    self->tick_id = 0;
+    self->max_fps = 0;
+    self->last_draw_time = 0;
+    self->state.downsample = GTK_CHART_DOWNSAMPLE_M4;
+    self->state.downsample_budget = 0;
+    self->state.text_serial = 0;
+    self->state.axes_node = NULL;
+    self->state.axes_valid = FALSE;
+    self->state.marker.shape = GTK_CHART_MARKER_CIRCLE;
+    self->state.marker.size = 3.0;
+    self->state.strip.enabled = FALSE;
+    self->state.strip.surface = NULL;
+    self->state.series_list = NULL;
+    self->state.series_serial = 0;
+    self->state.data_serial = 0;
+    self->state.tiled = FALSE;
+    self->state.density = 0;
+    self->state.csv_precision = -1;
+    self->state.csv_delimiter = ',';
+    self->state.points.storage = GTK_CHART_STORAGE_DOUBLE;
+    self->state.points.x_start = 0;
+    self->state.points.x_step = 1.0;
+    self->state.points.y_offset = 0;
+    self->state.points.y_step = 1.0;
+
+    // Default series fed by gtk_chart_plot_point()
+    chart_ring_add_series(&self->state.points);
+
+    // Automatically use GTK font
+    GtkSettings *widget_settings = gtk_widget_get_settings(&self->parent_instance);
+    GValue font_name_value = G_VALUE_INIT;
+    g_object_get_property(G_OBJECT (widget_settings), "gtk-font-name", &font_name_value);
+    gchar *font_string = g_strdup_value_contents(&font_name_value);
+
+    // Extract name of font from font string ("<name> <size>")
+    gchar *font_name = &font_string[1]; // Skip "
+    for (unsigned int i=0; i<strlen(font_name); i++)
+    {
+        if (isdigit((int)font_name[i]))
+        {
+            font_name[i-1] = 0;
+            break;
+        }
+    }
+    self->state.font_name = g_strdup(font_name);
+    g_free(font_string);
+
+    //gtk_widget_init_template (GTK_WIDGET (self));
+}
+
+static void gtk_chart_finalize (GObject *object)
+{
+    GtkChart *self = GTK_CHART (object);
+
+    G_OBJECT_CLASS (gtk_chart_parent_class)->finalize (G_OBJECT (self));
+}
+
+static void gtk_chart_dispose (GObject *object)
+{
+    GtkChart *self = GTK_CHART (object);
+    GtkWidget *child;
+
+    while ((child = gtk_widget_get_first_child (GTK_WIDGET (object))))
+    {
+        gtk_widget_unparent (child);
+    }
+
+    // Cleanup
+    if (self->tick_id != 0)
+    {
+        gtk_widget_remove_tick_callback(GTK_WIDGET(self), self->tick_id);
+        self->tick_id = 0;
+    }
+
+    g_clear_pointer(&self->state.axes_node, gsk_render_node_unref);
+    g_clear_pointer(&self->state.marker.surface, cairo_surface_destroy);
+    g_clear_object(&self->state.marker.texture);
+    g_clear_pointer(&self->state.strip.surface, cairo_surface_destroy);
+
+    g_free(self->state.title);
+    g_free(self->state.label);
+    g_free(self->state.x_label);
+    g_free(self->state.y_label);
+
+    chart_ring_free(&self->state.points);
+    chart_mapped_close(&self->state.mapped);
+    g_slist_free_full(g_steal_pointer(&self->state.series_list), chart_series_free);
+    g_clear_slist(&self->state.point_list, NULL);
+    g_clear_pointer(&self->state.point_cache, g_free);
+
+    g_clear_slist(&self->state.slice_list, g_free);
+
+    gdk_display_sync(gdk_display_get_default());
+
+    G_OBJECT_CLASS (gtk_chart_parent_class)->dispose (object);
+}
+
+static gboolean chart_tick_callback(GtkWidget *widget, GdkFrameClock *frame_clock, gpointer user_data)
+{
+    UNUSED(user_data);
+
+    GtkChart *self = GTK_CHART(widget);
+    gint64 now = gdk_frame_clock_get_frame_time(frame_clock);
+
+    if (!self->dirty)
+    {
+        self->tick_id = 0;
+        return G_SOURCE_REMOVE;
+    }
+
+    // Hold back redraw until the minimum frame interval has passed
+    if (self->max_fps > 0 && (now - self->last_draw_time) < (gint64) (G_USEC_PER_SEC / self->max_fps))
+    {
+        return G_SOURCE_CONTINUE;
+    }
+
+    self->dirty = FALSE;
+    self->last_draw_time = now;
+    gtk_widget_queue_draw(widget);
+
+    self->tick_id = 0;
+    return G_SOURCE_REMOVE;
+}
+
+// Coalesce any number of data changes into at most one redraw per frame
+static void chart_queue_redraw(GtkChart *self)
+{
+    if (!GTK_IS_WIDGET(self))
+    {
+        return;
+    }
+
+    self->dirty = TRUE;
+
+    if (self->tick_id == 0)
+    {
+        self->tick_id = gtk_widget_add_tick_callback(GTK_WIDGET(self), chart_tick_callback, NULL, NULL);
+    }
+}
+
+// Work item run on worker threads shared by all charts, embedded first in job specific structs
+struct chart_job_t
+{
+    void (*run)(struct chart_job_t *job);
+    struct chart_batch_t *batch;
+};
+
+// Jobs pushed together and waited for as a whole
+struct chart_batch_t
+{
+    GMutex mutex;
+    GCond cond;
+    unsigned int pending;
+};
+
+static void chart_pool_func(gpointer data, gpointer user_data)
+{
+    struct chart_job_t *job = data;
+    struct chart_batch_t *batch = job->batch;
+
+    UNUSED(user_data);
+
+    job->run(job);
+
+    g_mutex_lock(&batch->mutex);
+    if (--batch->pending == 0)
+    {
+        g_cond_signal(&batch->cond);
+    }
+    g_mutex_unlock(&batch->mutex);
+}
+
+static unsigned int chart_pool_n_threads(void)
+{
+    return MAX(g_get_num_processors(), 1);
+}
+
+// Run n jobs stored job_size bytes apart on the shared pool, returns once all have finished.
+// Jobs must not wait on the pool themselves.
+static void chart_pool_run(void *jobs, size_t job_size, unsigned int n)
+{
+    static GThreadPool *pool = NULL;
+    static gsize pool_init = 0;
+    struct chart_batch_t batch;
+
+    if (g_once_init_enter(&pool_init))
+    {
+        pool = g_thread_pool_new(chart_pool_func, NULL, chart_pool_n_threads(), FALSE, NULL);
+        g_once_init_leave(&pool_init, 1);
+    }
+
+    g_mutex_init(&batch.mutex);
+    g_cond_init(&batch.cond);
+    batch.pending = n;
+
+    for (unsigned int i = 0; i < n; i++)
+    {
+        struct chart_job_t *job = (struct chart_job_t *) ((guint8 *) jobs + i * job_size);
+
+        job->batch = &batch;
+        if (pool == NULL || n == 1 || !g_thread_pool_push(pool, job, NULL))
+        {
+            chart_pool_func(job, NULL);
+        }
+    }
+
+    g_mutex_lock(&batch.mutex);
+    while (batch.pending > 0)
+    {
+        g_cond_wait(&batch.cond, &batch.mutex);
+    }
+    g_mutex_unlock(&batch.mutex);
+
+    g_mutex_clear(&batch.mutex);
+    g_cond_clear(&batch.cond);
+}
+
+// Drawing backend used by all chart types. With GTK >= 4.14 the widget emits GSK
+// render nodes directly (color, stroke, fill and text nodes), otherwise and for
+// cairo targets the same calls are rasterized by cairo.
+#if GTK_CHECK_VERSION(4, 14, 0)
+#define CHART_HAVE_GSK_PATH 1
+#endif
+
+// Shaped text by font, size and string, shared by all charts drawn on the main thread
+struct chart_text_cache_t
+{
+    GHashTable *entries;
+    PangoContext *context;
+};
+
+static struct chart_text_cache_t chart_text_cache;
+
+// Offscreen rendering of a copy of chart state, owned by an export task
+struct chart_export_t
+{
+    struct chart_state_t state; // Copy of chart state, drawn on a worker thread
+    cairo_t *cr;
+    int scale;
+    int width;
+    int height;
+    char *filename;
+    struct chart_text_cache_t text_cache;
+};
+
+#define CHART_CANVAS_STACK_SIZE 8
+#define CHART_TEXT_CACHE_SIZE 512
+#define CHART_STRIP_MARGIN 8
+
+struct chart_canvas_state_t
+{
+    GdkRGBA color;
+    double line_width;
+    double font_size;
+    cairo_line_cap_t line_cap;
+    cairo_line_join_t line_join;
+    gboolean y_up;          // Coordinate system has inverted y-axis, text is flipped back upright
+};
+
+struct chart_canvas_t
+{
+    cairo_t *cr;            // Cairo backend, NULL when emitting GSK nodes
+    gboolean own_cr;
+    GtkSnapshot *snapshot;
+    PangoContext *pango_context;
+    struct chart_text_cache_t *text_cache;
+    int scale;              // Device scale of target
+    const char *font_name;
+#ifdef CHART_HAVE_GSK_PATH
+    GskPathBuilder *builder;
+#endif
+    gboolean has_path;
+    gboolean has_point;
+    int n_clips;
+    struct chart_canvas_state_t state;
+    struct chart_canvas_state_t stack[CHART_CANVAS_STACK_SIZE];
+    int depth;
+};
+
+static void chart_canvas_init_state(struct chart_canvas_t *canvas, const char *font_name)
+{
+    canvas->font_name = font_name;
+    canvas->state.color = (GdkRGBA) { 0, 0, 0, 1 };
+    canvas->state.line_width = 2.0;
+    canvas->state.font_size = 10.0;
+    canvas->state.line_cap = CAIRO_LINE_CAP_BUTT;
+    canvas->state.line_join = CAIRO_LINE_JOIN_MITER;
+    canvas->state.y_up = FALSE;
+    canvas->depth = 0;
+    canvas->n_clips = 0;
+    canvas->has_path = FALSE;
+    canvas->has_point = FALSE;
+}
+
+static void chart_canvas_begin_cairo(struct chart_canvas_t *canvas, struct chart_state_t *self, cairo_t *cr);
+
+// Begin drawing widget contents of size w x h into snapshot, offscreen copies draw into their export surface
+static void chart_canvas_begin(struct chart_canvas_t *canvas,
+                               struct chart_state_t *self,
+                               GtkSnapshot *snapshot,
+                               float w,
+                               float h)
+{
+    if (self->export != NULL)
+    {
+        chart_canvas_begin_cairo(canvas, self, self->export->cr);
+        return;
+    }
+
+    memset(canvas, 0, sizeof(*canvas));
+    chart_canvas_init_state(canvas, self->font_name);
+    canvas->snapshot = snapshot;
+    canvas->pango_context = g_object_ref(self->pango_context);
+    canvas->text_cache = &chart_text_cache;
+    canvas->scale = self->scale;
+
+#ifdef CHART_HAVE_GSK_PATH
+    canvas->builder = gsk_path_builder_new();
+    gtk_snapshot_save(snapshot);
+#else
+    canvas->cr = gtk_snapshot_append_cairo (snapshot, &GRAPHENE_RECT_INIT(0, 0, w, h));
+    canvas->own_cr = TRUE;
+    cairo_set_antialias (canvas->cr, CAIRO_ANTIALIAS_FAST);
+    cairo_set_tolerance (canvas->cr, 1.5);
+#endif
+    UNUSED(w);
+    UNUSED(h);
+}
+
+// Begin drawing data into existing cairo context without text, so no Pango context is created.
+// Used for strip and tile surfaces, which are redrawn every frame, tiles on pool threads.
+static void chart_canvas_begin_cairo_data(struct chart_canvas_t *canvas, struct chart_state_t *self, cairo_t *cr)
+{
+    double x_scale, y_scale;
+
+    cairo_surface_get_device_scale(cairo_get_target(cr), &x_scale, &y_scale);
+
+    memset(canvas, 0, sizeof(*canvas));
+    chart_canvas_init_state(canvas, self->font_name);
+    canvas->cr = cr;
+    canvas->scale = (int) x_scale;
+
+    cairo_save(cr);
+    cairo_set_antialias (cr, CAIRO_ANTIALIAS_FAST);
+    cairo_set_tolerance (cr, 1.5);
+}
+
+// Begin drawing into existing cairo context, e.g. of an offscreen surface
+static void chart_canvas_begin_cairo(struct chart_canvas_t *canvas, struct chart_state_t *self, cairo_t *cr)
+{
+    chart_canvas_begin_cairo_data(canvas, self, cr);
+    canvas->pango_context = pango_cairo_create_context(cr);
+    canvas->text_cache = (self->export != NULL) ? &self->export->text_cache : &chart_text_cache;
+}
+
+static void chart_canvas_end(struct chart_canvas_t *canvas)
+{
+    if (canvas->cr != NULL)
+    {
+        if (canvas->own_cr)
+        {
+            cairo_destroy(canvas->cr);
+        }
+        else
+        {
+            cairo_restore(canvas->cr);
+        }
+    }
+#ifdef CHART_HAVE_GSK_PATH
+    else
+    {
+        while (canvas->n_clips-- > 0)
+        {
+            gtk_snapshot_pop(canvas->snapshot);
+        }
+        gtk_snapshot_restore(canvas->snapshot);
+    }
+    g_clear_pointer(&canvas->builder, gsk_path_builder_unref);
+#endif
+
+    g_clear_object(&canvas->pango_context);
+}
+
+static void chart_canvas_save(struct chart_canvas_t *canvas)
+{
+    g_assert(canvas->depth < CHART_CANVAS_STACK_SIZE);
+
+    canvas->stack[canvas->depth++] = canvas->state;
+
+    if (canvas->cr != NULL)
+    {
+        cairo_save(canvas->cr);
+    }
+    else
+    {
+        gtk_snapshot_save(canvas->snapshot);
+    }
+}
+
+static void chart_canvas_restore(struct chart_canvas_t *canvas)
+{
+    g_assert(canvas->depth > 0);
+
+    canvas->state = canvas->stack[--canvas->depth];
+
+    if (canvas->cr != NULL)
+    {
+        cairo_restore(canvas->cr);
+    }
+    else
+    {
+        gtk_snapshot_restore(canvas->snapshot);
+    }
+}
+
+static void chart_canvas_translate(struct chart_canvas_t *canvas, double x, double y)
+{
+    if (canvas->cr != NULL)
+    {
+        cairo_translate(canvas->cr, x, y);
+    }
+    else
+    {
+        gtk_snapshot_translate(canvas->snapshot, &GRAPHENE_POINT_INIT(x, y));
+    }
+}
+
+static void chart_canvas_scale(struct chart_canvas_t *canvas, double sx, double sy)
+{
+    if (sy < 0)
+    {
+        canvas->state.y_up = !canvas->state.y_up;
+    }
+
+    if (canvas->cr != NULL)
+    {
+        cairo_scale(canvas->cr, sx, sy);
+    }
+    else
+    {
+        gtk_snapshot_scale(canvas->snapshot, sx, sy);
+    }
+}
+
+static void chart_canvas_rotate(struct chart_canvas_t *canvas, double angle)
+{
+    if (canvas->cr != NULL)
+    {
+        cairo_rotate(canvas->cr, angle);
+    }
+    else
+    {
+        gtk_snapshot_rotate(canvas->snapshot, angle * 180.0 / G_PI);
+    }
+}
+
+static void chart_canvas_set_color(struct chart_canvas_t *canvas, const GdkRGBA *color)
+{
+    canvas->state.color = *color;
+
+    if (canvas->cr != NULL)
+    {
+        gdk_cairo_set_source_rgba (canvas->cr, color);
+    }
+}
+
+static void chart_canvas_set_rgba(struct chart_canvas_t *canvas, double r, double g, double b, double a)
+{
+    GdkRGBA color = { r, g, b, a };
+
+    chart_canvas_set_color(canvas, &color);
+}
+
+static void chart_canvas_set_line_width(struct chart_canvas_t *canvas, double width)
+{
+    canvas->state.line_width = width;
+
+    if (canvas->cr != NULL)
+    {
+        cairo_set_line_width (canvas->cr, width);
+    }
+}
+
+static void chart_canvas_set_line_join(struct chart_canvas_t *canvas, cairo_line_join_t join)
+{
+    canvas->state.line_join = join;
+
+    if (canvas->cr != NULL)
+    {
+        cairo_set_line_join(canvas->cr, join);
+    }
+}
+
+static void chart_canvas_set_font_size(struct chart_canvas_t *canvas, double size)
+{
+    canvas->state.font_size = size;
+}
+
+// Path construction. Transformations must not change while a path is open.
+static void chart_canvas_move_to(struct chart_canvas_t *canvas, double x, double y)
+{
+    canvas->has_path = TRUE;
+    canvas->has_point = TRUE;
+
+    if (canvas->cr != NULL)
+    {
+        cairo_move_to(canvas->cr, x, y);
+        return;
+    }
+#ifdef CHART_HAVE_GSK_PATH
+    gsk_path_builder_move_to(canvas->builder, x, y);
+#endif
+}
+
+static void chart_canvas_line_to(struct chart_canvas_t *canvas, double x, double y)
+{
+    if (!canvas->has_point)
+    {
+        chart_canvas_move_to(canvas, x, y);
+        return;
+    }
+
+    if (canvas->cr != NULL)
+    {
+        cairo_line_to(canvas->cr, x, y);
+        return;
+    }
+#ifdef CHART_HAVE_GSK_PATH
+    gsk_path_builder_line_to(canvas->builder, x, y);
+#endif
+}
+
+static void chart_canvas_close_path(struct chart_canvas_t *canvas)
+{
+    if (canvas->cr != NULL)
+    {
+        cairo_close_path(canvas->cr);
+        return;
+    }
+#ifdef CHART_HAVE_GSK_PATH
+    gsk_path_builder_close(canvas->builder);
+#endif
+}
+
+// Arc in increasing angle direction, connected to the current point like cairo_arc()
+static void chart_canvas_arc(struct chart_canvas_t *canvas,
+                             double xc,
+                             double yc,
+                             double radius,
+                             double angle1,
+                             double angle2)
+{
+    if (canvas->cr != NULL)
+    {
+        cairo_arc(canvas->cr, xc, yc, radius, angle1, angle2);
+        canvas->has_path = TRUE;
+        canvas->has_point = TRUE;
+        return;
+    }
+
+    while (angle2 < angle1)
+    {
+        angle2 += 2 * G_PI;
+    }
+
+    chart_canvas_line_to(canvas, xc + radius * cos(angle1), yc + radius * sin(angle1));
+
+#ifdef CHART_HAVE_GSK_PATH
+    // Split into quarter turns so each SVG arc is unambiguous
+    while (angle1 < angle2)
+    {
+        double angle = MIN(angle2, angle1 + G_PI / 2);
+        gsk_path_builder_svg_arc_to(canvas->builder, radius, radius, 0, FALSE, TRUE,
+                                    xc + radius * cos(angle), yc + radius * sin(angle));
+        angle1 = angle;
+    }
+#endif
+}
+
+#ifdef CHART_HAVE_GSK_PATH
+static GskPath * chart_canvas_take_path(struct chart_canvas_t *canvas)
+{
+    GskPath *path = gsk_path_builder_free_to_path(canvas->builder);
+
+    canvas->builder = gsk_path_builder_new();
+
+    return path;
+}
+
+static GskLineCap chart_canvas_gsk_line_cap(cairo_line_cap_t cap)
+{
+    switch (cap)
+    {
+        case CAIRO_LINE_CAP_ROUND:
+            return GSK_LINE_CAP_ROUND;
+        case CAIRO_LINE_CAP_SQUARE:
+            return GSK_LINE_CAP_SQUARE;
+        default:
+            return GSK_LINE_CAP_BUTT;
+    }
+}
+
+static GskLineJoin chart_canvas_gsk_line_join(cairo_line_join_t join)
+{
+    switch (join)
+    {
+        case CAIRO_LINE_JOIN_ROUND:
+            return GSK_LINE_JOIN_ROUND;
+        case CAIRO_LINE_JOIN_BEVEL:
+            return GSK_LINE_JOIN_BEVEL;
+        default:
+            return GSK_LINE_JOIN_MITER;
+    }
+}
+#endif
+
+static void chart_canvas_stroke(struct chart_canvas_t *canvas)
+{
+    gboolean has_path = canvas->has_path;
+
+    canvas->has_path = FALSE;
+    canvas->has_point = FALSE;
+
+    if (canvas->cr != NULL)
+    {
+        cairo_stroke(canvas->cr);
+        return;
+    }
+#ifdef CHART_HAVE_GSK_PATH
+    if (!has_path)
+    {
+        return;
+    }
+
+    GskPath *path = chart_canvas_take_path(canvas);
+    GskStroke *stroke = gsk_stroke_new(canvas->state.line_width);
+
+    gsk_stroke_set_line_cap(stroke, chart_canvas_gsk_line_cap(canvas->state.line_cap));
+    gsk_stroke_set_line_join(stroke, chart_canvas_gsk_line_join(canvas->state.line_join));
+    gtk_snapshot_append_stroke(canvas->snapshot, path, stroke, &canvas->state.color);
+
+    gsk_stroke_free(stroke);
+    gsk_path_unref(path);
+#else
+    UNUSED(has_path);
+#endif
+}
+
+static void chart_canvas_fill(struct chart_canvas_t *canvas)
+{
+    gboolean has_path = canvas->has_path;
+
+    canvas->has_path = FALSE;
+    canvas->has_point = FALSE;
+
+    if (canvas->cr != NULL)
+    {
+        cairo_fill(canvas->cr);
+        return;
+    }
+#ifdef CHART_HAVE_GSK_PATH
+    if (!has_path)
+    {
+        return;
+    }
+
+    GskPath *path = chart_canvas_take_path(canvas);
+
+    gtk_snapshot_append_fill(canvas->snapshot, path, GSK_FILL_RULE_WINDING, &canvas->state.color);
+    gsk_path_unref(path);
+#else
+    UNUSED(has_path);
+#endif
+}
+
+// Fill axis aligned rectangle, a plain color node on the GSK backend
+static void chart_canvas_fill_rect(struct chart_canvas_t *canvas, double x, double y, double w, double h)
+{
+    if (canvas->cr != NULL)
+    {
+        cairo_rectangle(canvas->cr, x, y, w, h);
+        cairo_fill(canvas->cr);
+        return;
+    }
+
+    gtk_snapshot_append_color(canvas->snapshot, &canvas->state.color, &GRAPHENE_RECT_INIT(x, y, w, h));
+}
+
+// Copy image surface into a texture, cairo ARGB32 is premultiplied native endian BGRA
+static GdkTexture * chart_texture_new_for_surface(cairo_surface_t *surface)
+{
+    int width = cairo_image_surface_get_width(surface);
+    int height = cairo_image_surface_get_height(surface);
+    int stride = cairo_image_surface_get_stride(surface);
+
+    cairo_surface_flush(surface);
+
+    GBytes *bytes = g_bytes_new(cairo_image_surface_get_data(surface), (gsize) stride * height);
+    GdkTexture *texture = gdk_memory_texture_new(width, height, GDK_MEMORY_DEFAULT, bytes, stride);
+    g_bytes_unref(bytes);
+
+    return texture;
+}
+
+// Paint image surface with its top left corner at (x, y), honoring its device scale
+static void chart_canvas_paint_surface(struct chart_canvas_t *canvas, cairo_surface_t *surface, double x, double y)
+{
+    if (canvas->cr != NULL)
+    {
+        cairo_set_source_surface(canvas->cr, surface, x, y);
+        cairo_paint(canvas->cr);
+        gdk_cairo_set_source_rgba (canvas->cr, &canvas->state.color);
+        return;
+    }
+
+    double x_scale, y_scale;
+    GdkTexture *texture = chart_texture_new_for_surface(surface);
+
+    cairo_surface_get_device_scale(surface, &x_scale, &y_scale);
+    gtk_snapshot_append_texture(canvas->snapshot,
+                                texture,
+                                &GRAPHENE_RECT_INIT(x, y,
+                                                    cairo_image_surface_get_width(surface) / x_scale,
+                                                    cairo_image_surface_get_height(surface) / y_scale));
+    g_object_unref(texture);
+}
+
+// Stamp marker sprite centered at (x, y), a texture node on the GSK backend
+static void chart_canvas_stamp(struct chart_canvas_t *canvas,
+                               const struct chart_marker_t *marker,
+                               double x,
+                               double y)
+{
+    double half = marker->extent / 2;
+
+    if (canvas->cr != NULL)
+    {
+        cairo_set_source_surface(canvas->cr, marker->surface, x - half, y - half);
+        cairo_rectangle(canvas->cr, x - half, y - half, marker->extent, marker->extent);
+        cairo_fill(canvas->cr);
+        return;
+    }
+
+    gtk_snapshot_append_texture(canvas->snapshot,
+                                marker->texture,
+                                &GRAPHENE_RECT_INIT(x - half, y - half, marker->extent, marker->extent));
+}
+
+// Clip remaining drawing to rectangle, only valid outside of save/restore
+static void chart_canvas_clip_rect(struct chart_canvas_t *canvas, double x, double y, double w, double h)
+{
+    g_assert(canvas->depth == 0);
+
+    if (canvas->cr != NULL)
+    {
+        cairo_rectangle(canvas->cr, x, y, w, h);
+        cairo_clip(canvas->cr);
+        return;
+    }
+
+    gtk_snapshot_push_clip(canvas->snapshot, &GRAPHENE_RECT_INIT(x, y, w, h));
+    canvas->n_clips++;
+}
+
+// Shaped text, measured once when entering the layout cache
+struct chart_text_t
+{
+    PangoLayout *layout;
+    PangoRectangle ink;
+    PangoRectangle logical;
+    double baseline;
+};
+
+// Process wide layout cache keyed by (font, size, string), shared by all chart instances.
+// Layouts are created from a private context so widgets don't thrash each other's entries.
+// Only used from the GTK main thread.
+
+static void chart_text_free(gpointer data)
+{
+    struct chart_text_t *entry = data;
+
+    g_object_unref(entry->layout);
+    g_free(entry);
+}
+
+// Drop all shaped text, called when font settings or scale change
+static void chart_text_cache_clear(struct chart_text_cache_t *cache)
+{
+    g_clear_pointer(&cache->entries, g_hash_table_destroy);
+    g_clear_object(&cache->context);
+}
+
+static PangoContext * chart_text_cache_context(struct chart_text_cache_t *cache, PangoContext *widget_context)
+{
+    PangoFontMap *font_map = pango_context_get_font_map(widget_context);
+
+    if (cache->context != NULL &&
+        pango_context_get_font_map(cache->context) != font_map)
+    {
+        chart_text_cache_clear(cache);
+    }
+
+    if (cache->context == NULL)
+    {
+        cache->context = pango_font_map_create_context(font_map);
+        pango_cairo_context_set_font_options(cache->context,
+                                             pango_cairo_context_get_font_options(widget_context));
+        pango_context_set_round_glyph_positions(cache->context,
+                                                pango_context_get_round_glyph_positions(widget_context));
+        cache->entries = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, chart_text_free);
+    }
+
+    return cache->context;
+}
+
+static const struct chart_text_t * chart_canvas_layout(struct chart_canvas_t *canvas, const char *text)
+{
+    g_assert(canvas->pango_context != NULL);
+
+    struct chart_text_cache_t *cache = canvas->text_cache;
+    PangoContext *context = chart_text_cache_context(cache, canvas->pango_context);
+    const char *font_name = canvas->font_name ? canvas->font_name : "";
+    char *key;
+    struct chart_text_t *entry;
+
+    if (text == NULL)
+    {
+        text = "";
+    }
+
+    key = g_strdup_printf("%s\x1f%g\x1f%s", font_name, canvas->state.font_size, text);
+    entry = g_hash_table_lookup(cache->entries, key);
+    if (entry != NULL)
+    {
+        g_free(key);
+        return entry;
+    }
+
+    // Bound memory of charts with ever changing strings
+    if (g_hash_table_size(cache->entries) >= CHART_TEXT_CACHE_SIZE)
+    {
+        g_hash_table_remove_all(cache->entries);
+    }
+
+    PangoFontDescription *desc = pango_font_description_new();
+
+    entry = g_new0(struct chart_text_t, 1);
+    entry->layout = pango_layout_new(context);
+    pango_font_description_set_family(desc, font_name);
+    pango_font_description_set_absolute_size(desc, canvas->state.font_size * PANGO_SCALE);
+    pango_layout_set_font_description(entry->layout, desc);
+    pango_layout_set_text(entry->layout, text, -1);
+    pango_font_description_free(desc);
+
+    pango_layout_get_pixel_extents(entry->layout, &entry->ink, &entry->logical);
+    entry->baseline = (double) pango_layout_get_baseline(entry->layout) / PANGO_SCALE;
+
+    g_hash_table_insert(cache->entries, key, entry);
+
+    return entry;
+}
+
+// Ink extents of text in current font, like cairo_text_extents()
+static void chart_canvas_text_extents(struct chart_canvas_t *canvas,
+                                      const char *text,
+                                      cairo_text_extents_t *extents)
+{
+    const struct chart_text_t *entry = chart_canvas_layout(canvas, text);
+
+    extents->x_bearing = entry->ink.x;
+    extents->y_bearing = entry->ink.y - entry->baseline;
+    extents->width = entry->ink.width;
+    extents->height = entry->ink.height;
+    extents->x_advance = entry->logical.width;
+    extents->y_advance = 0;
+}
+
+// Draw text with baseline origin at (x, y), kept upright in inverted coordinate systems
+static void chart_canvas_text(struct chart_canvas_t *canvas, double x, double y, const char *text)
+{
+    if (text == NULL)
+    {
+        return;
+    }
+
+    const struct chart_text_t *entry = chart_canvas_layout(canvas, text);
+
+    chart_canvas_save(canvas);
+    chart_canvas_translate(canvas, x, y);
+    if (canvas->state.y_up)
+    {
+        chart_canvas_scale(canvas, 1, -1);
+    }
+    chart_canvas_translate(canvas, 0, -entry->baseline);
+
+    if (canvas->cr != NULL)
+    {
+        gdk_cairo_set_source_rgba (canvas->cr, &canvas->state.color);
+        cairo_move_to(canvas->cr, 0, 0);
+        // Cached layouts keep the shaping of the cache context, don't update them from cr
+        pango_cairo_show_layout(canvas->cr, entry->layout);
+        cairo_new_path(canvas->cr);
+    }
+    else
+    {
+        gtk_snapshot_append_layout(canvas->snapshot, entry->layout, &canvas->state.color);
+    }
+
+    chart_canvas_restore(canvas);
+}
+
+struct chart_line_t
+{
+    struct chart_canvas_t *canvas;
+    gboolean connected;     // Last emitted vertex is visible, continue line from it
+    gboolean decimate;      // M4 decimation enabled
+    double bucket_width;    // Width of decimation bucket in pixels
+    long bucket;            // Current bucket index (-1 = none)
+    double first_x, first_y;
+    double min_x, min_y;
+    double max_x, max_y;
+    double last_x, last_y;
+};
+
+// Add vertex to path, stroked once per frame by chart_line_stroke()
+static void chart_line_vertex(struct chart_line_t *line, double x, double y)
+{
+    if (!line->connected)
+    {
+        // Start new sub path when coming back into view
+        chart_canvas_move_to(line->canvas, x, y);
+        line->connected = TRUE;
+    }
+    else
+    {
+        // Continue the line if previous point was visible
+        chart_canvas_line_to(line->canvas, x, y);
+    }
+}
+
+// Emit first, min, max and last point of bucket in x order, skipping duplicates
+static void chart_line_flush(struct chart_line_t *line)
+{
+    double vx[4], vy[4];
+    int n = 0;
+
+    if (line->bucket < 0)
+    {
+        return;
+    }
+
+    vx[n] = line->first_x;
+    vy[n++] = line->first_y;
+    if (line->min_x <= line->max_x)
+    {
+        vx[n] = line->min_x;
+        vy[n++] = line->min_y;
+        vx[n] = line->max_x;
+        vy[n++] = line->max_y;
+    }
+    else
+    {
+        vx[n] = line->max_x;
+        vy[n++] = line->max_y;
+        vx[n] = line->min_x;
+        vy[n++] = line->min_y;
+    }
+    vx[n] = line->last_x;
+    vy[n++] = line->last_y;
+
+    for (int i = 0; i < n; i++)
+    {
+        if (i > 0 && vx[i] == vx[i - 1] && vy[i] == vy[i - 1])
+        {
+            continue;
+        }
+        chart_line_vertex(line, vx[i], vy[i]);
+    }
+
+    line->bucket = -1;
+}
+
+static void chart_line_point(struct chart_line_t *line, double x, double y)
+{
+    if (!line->decimate)
+    {
+        chart_line_vertex(line, x, y);
+        return;
+    }
+
+    long bucket = (long) floor(x / line->bucket_width);
+
+    if (bucket != line->bucket)
+    {
+        chart_line_flush(line);
+
+        line->bucket = bucket;
+        line->first_x = line->min_x = line->max_x = x;
+        line->first_y = line->min_y = line->max_y = y;
+    }
+    else if (y < line->min_y)
+    {
+        line->min_x = x;
+        line->min_y = y;
+    }
+    else if (y > line->max_y)
+    {
+        line->max_x = x;
+        line->max_y = y;
+    }
+
+    line->last_x = x;
+    line->last_y = y;
+}
+
+// End current line segment
+static void chart_line_break(struct chart_line_t *line)
+{
+    chart_line_flush(line);
+    line->connected = FALSE;
+}
+
+// Stroke all line segments as a single path
+static void chart_line_stroke(struct chart_line_t *line)
+{
+    chart_line_break(line);
+
+    chart_canvas_set_line_join(line->canvas, CAIRO_LINE_JOIN_ROUND);
+    chart_canvas_stroke(line->canvas);
+}
+
+// Trace marker shape of given size centered at origin, all shapes are symmetric
+// so sprites look the same in inverted coordinate systems
+static void chart_marker_path(cairo_t *cr, GtkChartMarker shape, double size)
+{
+    double r = size / 2;
+
+    switch (shape)
+    {
+        case GTK_CHART_MARKER_SQUARE:
+            cairo_rectangle(cr, -r, -r, size, size);
+            cairo_fill(cr);
+            break;
+
+        case GTK_CHART_MARKER_DIAMOND:
+            cairo_move_to(cr, 0, -r);
+            cairo_line_to(cr, r, 0);
+            cairo_line_to(cr, 0, r);
+            cairo_line_to(cr, -r, 0);
+            cairo_close_path(cr);
+            cairo_fill(cr);
+            break;
+
+        case GTK_CHART_MARKER_CROSS:
+            cairo_set_line_width(cr, MAX(size / 4, 1.0));
+            cairo_move_to(cr, -r, -r);
+            cairo_line_to(cr, r, r);
+            cairo_move_to(cr, -r, r);
+            cairo_line_to(cr, r, -r);
+            cairo_stroke(cr);
+            break;
+
+        case GTK_CHART_MARKER_PLUS:
+            cairo_set_line_width(cr, MAX(size / 4, 1.0));
+            cairo_move_to(cr, -r, 0);
+            cairo_line_to(cr, r, 0);
+            cairo_move_to(cr, 0, -r);
+            cairo_line_to(cr, 0, r);
+            cairo_stroke(cr);
+            break;
+
+        case GTK_CHART_MARKER_CIRCLE:
+        default:
+            cairo_arc(cr, 0, 0, r, 0, 2 * G_PI);
+            cairo_fill(cr);
+            break;
+    }
+}
+
+// Render marker sprite unless it is up to date with shape, size, color and device scale,
+// the texture is only made for stamping into snapshots
+static void chart_marker_update(struct chart_marker_t *marker,
+                                GtkChartMarker shape,
+                                double size,
+                                const GdkRGBA *color,
+                                int scale,
+                                gboolean texture)
+{
+    if (marker->surface != NULL &&
+        marker->shape == shape &&
+        marker->size == size &&
+        marker->scale == scale &&
+        gdk_rgba_equal(&marker->color, color))
+    {
+        if (texture && marker->texture == NULL)
+        {
+            marker->texture = chart_texture_new_for_surface(marker->surface);
+        }
+        return;
+    }
+
+    g_clear_pointer(&marker->surface, cairo_surface_destroy);
+    g_clear_object(&marker->texture);
+
+    marker->shape = shape;
+    marker->size = size;
+    marker->color = *color;
+    marker->scale = scale;
+    marker->extent = ceil(marker->size) + 2;
+
+    int pixels = (int) marker->extent * scale;
+    marker->surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, pixels, pixels);
+
+    cairo_t *cr = cairo_create(marker->surface);
+    cairo_scale(cr, scale, scale);
+    cairo_translate(cr, marker->extent / 2, marker->extent / 2);
+    gdk_cairo_set_source_rgba(cr, color);
+    chart_marker_path(cr, marker->shape, marker->size);
+    cairo_destroy(cr);
+
+    cairo_surface_set_device_scale(marker->surface, scale, scale);
+    if (texture)
+    {
+        marker->texture = chart_texture_new_for_surface(marker->surface);
+    }
+}
+
+struct chart_plot_t
+{
+    struct chart_state_t *self;
+    struct chart_canvas_t *canvas;
+    double x_origin;        // Data x mapped to plot x = 0
+    double x_scale;
+    double y_scale;
+    gboolean x_culled;      // Points are pre-culled on x by index range, skip x test
+    gboolean summarize;     // Draw history and file blocks within one bucket from their summaries
+    struct chart_line_t line;
+    unsigned int series;    // Series whose y values are plotted
+    struct chart_marker_t *marker;
+    guint8 *covered;        // Pixels already stamped by an opaque marker, NULL to stamp all points
+    int covered_width;
+    int covered_height;
+};
+
+// Stamp scatter marker at pixel aligned position, skipping pixels covered by an identical stamp
+static void chart_plot_marker(struct chart_plot_t *plot, double x, double y)
+{
+    x = round(x);
+    y = round(y);
+
+    if (plot->covered != NULL)
+    {
+        int px = (int) x;
+        int py = (int) y;
+
+        if (px >= 0 && py >= 0 && px < plot->covered_width && py < plot->covered_height)
+        {
+            size_t bit = (size_t) py * plot->covered_width + px;
+
+            if (plot->covered[bit / 8] & (1u << (bit % 8)))
+            {
+                return;
+            }
+            plot->covered[bit / 8] |= 1u << (bit % 8);
+        }
+    }
+
+    chart_canvas_stamp(plot->canvas, plot->marker, x, y);
+}
+
+static void chart_plot_data_point(struct chart_plot_t *plot, double point_x, double point_y)
+{
+    struct chart_state_t *self = plot->self;
+
+    gboolean point_in_viewport = ((plot->x_culled ||
+                                  (point_x >= self->x_min && point_x <= self->x_max)) &&
+                                  point_y >= self->y_min &&
+                                  point_y <= self->y_max);
+
+    // Adjust coordinates by min values
+    double x_coord = (point_x - plot->x_origin) * plot->x_scale;
+    double y_coord = (point_y - self->y_min) * plot->y_scale;
+
+    switch (self->type)
+    {
+        case GTK_CHART_TYPE_LINE:
+            if (point_in_viewport)
+            {
+                chart_line_point(&plot->line, x_coord, y_coord);
+            }
+            else
+            {
+                // Start a new line segment when coming back into view
+                chart_line_break(&plot->line);
+            }
+            break;
+
+        case GTK_CHART_TYPE_SCATTER:
+            if (point_in_viewport)
+            {
+                // Stamp marker sprite, pixels already covered are skipped
+                chart_plot_marker(plot, x_coord, y_coord);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+#define CHART_PLOT_BATCH 256
+
+// Plot contiguous points, transformed to plot coordinates and culled by the vectorized kernel
+static void chart_plot_points(struct chart_plot_t *plot, const double *x, const double *y, size_t n)
+{
+    struct chart_state_t *self = plot->self;
+    struct chart_transform_t transform =
+    {
+        .x_origin = plot->x_origin,
+        .y_origin = self->y_min,
+        .x_scale = plot->x_scale,
+        .y_scale = plot->y_scale,
+        .x_min = plot->x_culled ? -INFINITY : self->x_min,
+        .x_max = plot->x_culled ? INFINITY : self->x_max,
+        .y_min = self->y_min,
+        .y_max = self->y_max,
+    };
+    double px[CHART_PLOT_BATCH];
+    double py[CHART_PLOT_BATCH];
+    guint8 visible[CHART_PLOT_BATCH];
+
+    for (size_t i = 0; i < n; i += CHART_PLOT_BATCH)
+    {
+        size_t count = MIN(n - i, CHART_PLOT_BATCH);
+        size_t n_visible = chart_transform(&transform, x + i, y + i, count, px, py, visible);
+
+        if (self->type == GTK_CHART_TYPE_LINE)
+        {
+            for (size_t k = 0; k < count; k++)
+            {
+                if (visible[k])
+                {
+                    chart_line_point(&plot->line, px[k], py[k]);
+                }
+                else
+                {
+                    // Start a new line segment when coming back into view
+                    chart_line_break(&plot->line);
+                }
+            }
+        }
+        else if (self->type == GTK_CHART_TYPE_SCATTER && n_visible > 0)
+        {
+            for (size_t k = 0; k < count; k++)
+            {
+                if (visible[k])
+                {
+                    chart_plot_marker(plot, px[k], py[k]);
+                }
+            }
+        }
+    }
+}
+
+// Find index range [start, end) of points to draw
+static gboolean chart_visible_range(struct chart_state_t *self, size_t *start, size_t *end, gboolean *x_culled)
+{
+    const struct chart_ring_t *ring = &self->points;
+
+    if (chart_ring_is_monotonic(ring))
+    {
+        // Binary search viewport, lines keep one neighbour on each side to reach the plot edges
+        *start = chart_ring_lower_bound(ring, 0, ring->count, self->x_min);
+        *end = chart_ring_upper_bound(ring, *start, ring->count, self->x_max);
+        if (self->type == GTK_CHART_TYPE_LINE)
+        {
+            *start = (*start > 0) ? *start - 1 : 0;
+            *end = MIN(*end + 1, ring->count);
+        }
+        *x_culled = TRUE;
+
+        return *start < *end;
+    }
+
+    // Scan for first and last point with x inside viewport
+    gboolean found = FALSE;
+
+    *start = *end = 0;
+    *x_culled = FALSE;
+
+    for (size_t i = 0; i < ring->count; i++)
+    {
+        double x = chart_ring_x(ring, chart_ring_slot(ring, i));
+
+        if (x >= self->x_min && x <= self->x_max)
+        {
+            if (!found)
+            {
+                *start = i;
+                found = TRUE;
+            }
+            *end = i + 1;
+        }
+    }
+
+    return found;
+}
+
+// Plot point at logical index of ring
+static inline void chart_plot_ring_point(struct chart_plot_t *plot, const struct chart_ring_t *ring, size_t index)
+{
+    size_t slot = chart_ring_slot(ring, index);
+
+    chart_plot_data_point(plot, chart_ring_x(ring, slot), chart_ring_y(ring, plot->series, slot));
+}
+
+// Plot points kept in history within data x range [x_min, x_max], oldest first. Only blocks
+// overlapping the range are decoded, lines take the edge point of the blocks next to it from
+// the block header and draw blocks falling into a single decimation column from their summary.
+static void chart_plot_history(struct chart_plot_t *plot, const struct chart_ring_t *ring, double x_min, double x_max)
+{
+    const struct chart_history_t *history = &ring->history;
+    struct chart_state_t *self = plot->self;
+    gboolean line = (self->type == GTK_CHART_TYPE_LINE);
+    size_t n_blocks = chart_history_n_blocks(history);
+    size_t first = 0;
+    size_t last = n_blocks;
+    double x[CHART_HISTORY_BLOCK];
+    double y[CHART_HISTORY_BLOCK];
+
+    if (plot->x_culled)
+    {
+        // Blocks are ordered by x, binary search first block reaching x_min and first one past x_max
+        size_t low = 0, high = n_blocks;
+        while (low < high)
+        {
+            size_t mid = low + (high - low) / 2;
+            if (chart_history_block(history, mid)->x_max < x_min)
+            {
+                low = mid + 1;
+            }
+            else
+            {
+                high = mid;
+            }
+        }
+        first = low;
+
+        high = n_blocks;
+        while (low < high)
+        {
+            size_t mid = low + (high - low) / 2;
+            if (chart_history_block(history, mid)->x_min <= x_max)
+            {
+                low = mid + 1;
+            }
+            else
+            {
+                high = mid;
+            }
+        }
+        last = low;
+
+        if (line)
+        {
+            first = (first > 0) ? first - 1 : 0;
+            last = MIN(last + 1, n_blocks);
+        }
+    }
+
+    for (size_t i = first; i < last; i++)
+    {
+        const struct chart_history_block_t *block = chart_history_block(history, i);
+        const struct chart_history_column_t *column =
+            (plot->series < block->n_series) ? &block->columns[plot->series] : NULL;
+
+        if (column == NULL || column->min > column->max ||
+            column->min > self->y_max || column->max < self->y_min)
+        {
+            // No samples in viewport
+            chart_line_break(&plot->line);
+            continue;
+        }
+
+        if (block->x_max < x_min || block->x_min > x_max)
+        {
+            if (plot->x_culled)
+            {
+                // Neighbour block of a line, only its point next to the range is needed
+                if (block->x_max < x_min)
+                {
+                    chart_plot_data_point(plot, block->x_last, column->last);
+                }
+                else
+                {
+                    chart_plot_data_point(plot, block->x_first, column->first);
+                }
+            }
+            else
+            {
+                chart_line_break(&plot->line);
+            }
+            continue;
+        }
+
+        if (plot->summarize && plot->x_culled && !column->gaps &&
+            column->min >= self->y_min && column->max <= self->y_max &&
+            floor((block->x_min - plot->x_origin) * plot->x_scale / plot->line.bucket_width) ==
+            floor((block->x_max - plot->x_origin) * plot->x_scale / plot->line.bucket_width))
+        {
+            // Whole block in one column, first/min/max/last are all the column keeps
+            double mid_x = (block->x_first + block->x_last) / 2;
+
+            chart_plot_data_point(plot, block->x_first, column->first);
+            if (column->last >= column->first)
+            {
+                chart_plot_data_point(plot, mid_x, column->min);
+                chart_plot_data_point(plot, mid_x, column->max);
+            }
+            else
+            {
+                chart_plot_data_point(plot, mid_x, column->max);
+                chart_plot_data_point(plot, mid_x, column->min);
+            }
+            chart_plot_data_point(plot, block->x_last, column->last);
+            continue;
+        }
+
+        chart_history_read(history, block, plot->series, x, y);
+        chart_plot_points(plot, x, y, block->count);
+    }
+}
+
+// Plot records of mapped series file within data x range [x_min, x_max]. Binary search on x
+// confines reads to the pages holding the range, lines add one neighbour on each side.
+// Like history blocks, whole blocks falling into one decimation column are drawn from their summary.
+static void chart_plot_mapped(struct chart_plot_t *plot, const struct chart_mapped_t *mapped, double x_min, double x_max)
+{
+    struct chart_state_t *self = plot->self;
+
+    if (plot->series >= mapped->n_series)
+    {
+        return;
+    }
+
+    size_t start = chart_mapped_search(mapped, 0, mapped->count, x_min, FALSE);
+    size_t end = chart_mapped_search(mapped, start, mapped->count, x_max, TRUE);
+
+    if (plot->x_culled && self->type == GTK_CHART_TYPE_LINE)
+    {
+        start = (start > 0) ? start - 1 : 0;
+        end = MIN(end + 1, mapped->count);
+    }
+
+    double x[CHART_PLOT_BATCH];
+    double y[CHART_PLOT_BATCH];
+
+    for (size_t i = start; i < end;)
+    {
+        size_t b = i / CHART_MAPPED_BLOCK;
+        size_t block_end = MIN((b + 1) * CHART_MAPPED_BLOCK, mapped->count);
+        const struct chart_mapped_block_t *block = &mapped->blocks[b];
+        const struct chart_mapped_column_t *column = &mapped->columns[b * mapped->n_series + plot->series];
+
+        if (column->min > column->max || column->min > self->y_max || column->max < self->y_min)
+        {
+            // No samples in viewport
+            chart_line_break(&plot->line);
+            i = MIN(block_end, end);
+            continue;
+        }
+
+        if (i == b * CHART_MAPPED_BLOCK && block_end <= end &&
+            plot->summarize && plot->x_culled && !column->gaps &&
+            column->min >= self->y_min && column->max <= self->y_max &&
+            floor((block->x_first - plot->x_origin) * plot->x_scale / plot->line.bucket_width) ==
+            floor((block->x_last - plot->x_origin) * plot->x_scale / plot->line.bucket_width))
+        {
+            // Whole block in one column, first/min/max/last are all the column keeps
+            double mid_x = (block->x_first + block->x_last) / 2;
+
+            chart_plot_data_point(plot, block->x_first, column->first);
+            if (column->last >= column->first)
+            {
+                chart_plot_data_point(plot, mid_x, column->min);
+                chart_plot_data_point(plot, mid_x, column->max);
+            }
+            else
+            {
+                chart_plot_data_point(plot, mid_x, column->max);
+                chart_plot_data_point(plot, mid_x, column->min);
+            }
+            chart_plot_data_point(plot, block->x_last, column->last);
+            i = block_end;
+            continue;
+        }
+
+        for (block_end = MIN(block_end, end); i < block_end; i += CHART_PLOT_BATCH)
+        {
+            size_t count = MIN(block_end - i, CHART_PLOT_BATCH);
+
+            for (size_t k = 0; k < count; k++)
+            {
+                x[k] = chart_mapped_value(mapped, i + k, 0);
+                y[k] = chart_mapped_value(mapped, i + k, plot->series + 1);
+            }
+            chart_plot_points(plot, x, y, count);
+        }
+        i = block_end;
+    }
+}
+
+// Largest-Triangle-Three-Buckets downsampling of points [start, end) to at most budget points
+static void chart_lttb(const struct chart_ring_t *ring,
+                       size_t start,
+                       size_t end,
+                       size_t budget,
+                       struct chart_plot_t *plot)
+{
+    unsigned int series = plot->series;
+    size_t n = end - start;
+
+    // First and last point plus at least one bucket
+    budget = MAX(budget, 3);
+    if (n <= budget)
+    {
+        for (size_t i = start; i < end; i++)
+        {
+            chart_plot_ring_point(plot, ring, i);
+        }
+        return;
+    }
+
+    // First and last points are always kept, the rest is split into budget - 2 buckets
+    double every = (double) (n - 2) / (budget - 2);
+    size_t a = start;
+
+    chart_plot_ring_point(plot, ring, a);
+
+    for (size_t i = 0; i < budget - 2; i++)
+    {
+        // Average of next bucket is the third triangle vertex
+        size_t avg_start = start + (size_t) ((i + 1) * every) + 1;
+        size_t avg_end = MIN(start + (size_t) ((i + 2) * every) + 1, end);
+        double avg_x = 0, avg_y = 0;
+        size_t avg_n = 0;
+
+        for (size_t j = avg_start; j < avg_end; j++)
+        {
+            size_t slot = chart_ring_slot(ring, j);
+            double y = chart_ring_y(ring, series, slot);
+
+            if (!isnan(y))
+            {
+                avg_x += chart_ring_x(ring, slot);
+                avg_y += y;
+                avg_n++;
+            }
+        }
+        if (avg_n > 0)
+        {
+            avg_x /= (double) avg_n;
+            avg_y /= (double) avg_n;
+        }
+        else
+        {
+            avg_x = chart_ring_x(ring, chart_ring_slot(ring, end - 1));
+            avg_y = chart_ring_y(ring, series, chart_ring_slot(ring, end - 1));
+        }
+
+        // Pick point in current bucket forming largest triangle with previous pick and average
+        size_t range_start = start + (size_t) (i * every) + 1;
+        size_t range_end = MIN(start + (size_t) ((i + 1) * every) + 1, end - 1);
+        double a_x = chart_ring_x(ring, chart_ring_slot(ring, a));
+        double a_y = chart_ring_y(ring, series, chart_ring_slot(ring, a));
+        double max_area = -1;
+        size_t next_a = range_start;
+
+        for (size_t j = range_start; j < range_end; j++)
+        {
+            size_t slot = chart_ring_slot(ring, j);
+            double area = fabs((a_x - avg_x) * (chart_ring_y(ring, series, slot) - a_y) -
+                               (a_x - chart_ring_x(ring, slot)) * (avg_y - a_y));
+            if (area > max_area)
+            {
+                max_area = area;
+                next_a = j;
+            }
+        }
+
+        a = next_a;
+        chart_plot_ring_point(plot, ring, a);
+    }
+
+    chart_plot_ring_point(plot, ring, end - 1);
+}
+
+// Draw M4 decimated line of monotonic series in O(columns * log n) using the min/max pyramid
+static void chart_line_columns(struct chart_plot_t *plot,
+                               const struct chart_ring_t *ring,
+                               size_t start,
+                               size_t end,
+                               double plot_width)
+{
+    struct chart_state_t *self = plot->self;
+    struct chart_line_t *line = &plot->line;
+    double bucket_x = line->bucket_width / plot->x_scale;
+    long n_columns = (long) ceil(plot_width / line->bucket_width);
+    long column = -1;
+
+    // Skip empty columns before the first point, columns left of viewport hold at most the neighbour point
+    if (start < end)
+    {
+        double first = floor((chart_ring_x(ring, chart_ring_slot(ring, start)) - plot->x_origin) / bucket_x);
+        column = (long) CLAMP(first, -1, n_columns + 1);
+    }
+
+    for (; column <= n_columns + 1 && start < end; column++)
+    {
+        size_t next = (column > n_columns) ? end :
+            chart_ring_lower_bound(ring, start, end, plot->x_origin + (column + 1) * bucket_x);
+        size_t n = next - start;
+        double min, max;
+
+        if (n == 0)
+        {
+            continue;
+        }
+
+        if (n > 4)
+        {
+            chart_ring_minmax(ring, plot->series, start, next, &min, &max);
+
+            if (min > max)
+            {
+                // No samples in column
+                chart_line_break(line);
+                start = next;
+                continue;
+            }
+        }
+
+        size_t first_slot = chart_ring_slot(ring, start);
+        size_t last_slot = chart_ring_slot(ring, next - 1);
+        double first_value = chart_ring_y(ring, plot->series, first_slot);
+        double last_value = chart_ring_y(ring, plot->series, last_slot);
+
+        if (n <= 4 || min < self->y_min || max > self->y_max || isnan(first_value) || isnan(last_value))
+        {
+            // Few points, line leaves viewport or has gaps at column edges, feed raw points
+            for (size_t i = start; i < next; i++)
+            {
+                chart_plot_ring_point(plot, ring, i);
+            }
+            start = next;
+            continue;
+        }
+
+        double first_x = (chart_ring_x(ring, first_slot) - plot->x_origin) * plot->x_scale;
+        double first_y = (first_value - self->y_min) * plot->y_scale;
+        double last_x = (chart_ring_x(ring, last_slot) - plot->x_origin) * plot->x_scale;
+        double last_y = (last_value - self->y_min) * plot->y_scale;
+        double mid_x = (first_x + last_x) / 2;
+        double min_y = (min - self->y_min) * plot->y_scale;
+        double max_y = (max - self->y_min) * plot->y_scale;
+
+        // Emit envelope in trend direction
+        chart_line_flush(line);
+        chart_line_vertex(line, first_x, first_y);
+        if (last_y >= first_y)
+        {
+            chart_line_vertex(line, mid_x, min_y);
+            chart_line_vertex(line, mid_x, max_y);
+        }
+        else
+        {
+            chart_line_vertex(line, mid_x, max_y);
+            chart_line_vertex(line, mid_x, min_y);
+        }
+        chart_line_vertex(line, last_x, last_y);
+
+        start = next;
+    }
+}
+
+// Draw title, axis labels, tick labels, axes and grid of line and scatter charts
+static void chart_draw_axes(struct chart_state_t *self,
+                            GtkSnapshot *snapshot,
+                            float h,
+                            float w)
+{
+    cairo_text_extents_t extents;
+    char value[20];
+
+    // Assume aspect ratio w:h = 2:1
+
+    // Set up drawing canvas
+    struct chart_canvas_t canvas;
+    chart_canvas_begin(&canvas, self, snapshot, w, h);
+    chart_canvas_set_color(&canvas, &self->text_color);
+
+    // Move coordinate system to bottom left
+    chart_canvas_translate(&canvas, 0, h);
+
+    // Invert y-axis
+    chart_canvas_scale(&canvas, 1, -1);
+
+    // Draw title
+    double title_font_size = 0.05 * h;  // 5% of total height
+    chart_canvas_set_font_size(&canvas, title_font_size);
+    chart_canvas_text_extents(&canvas, self->title, &extents);
+    chart_canvas_text(&canvas, 0.5 * w - extents.width/2, 0.9 * h - extents.height/2, self->title);
+
+    // Draw x-axis label
+    chart_canvas_set_font_size(&canvas, 11.0 * (w/650));
+    chart_canvas_text_extents(&canvas, self->x_label, &extents);
+    chart_canvas_text(&canvas, 0.5 * w - extents.width/2, 0.075 * h, self->x_label);
+
+    // Draw y-axis label
+    chart_canvas_text_extents(&canvas, self->y_label, &extents);
+    chart_canvas_save(&canvas);
+    chart_canvas_translate(&canvas, 0.035 * w, 0.5 * h - extents.width/2);
+    chart_canvas_rotate(&canvas, M_PI/2);
+    chart_canvas_text(&canvas, 0, 0, self->y_label);
+    chart_canvas_restore(&canvas);
+
+    // Draw x-axis
+    chart_canvas_set_color(&canvas, &self->axis_color);
+    chart_canvas_set_line_width(&canvas, 1);
+    chart_canvas_move_to(&canvas, 0.1 * w, 0.2 * h);
+    chart_canvas_line_to(&canvas, 0.9 * w, 0.2 * h);
+    chart_canvas_stroke(&canvas);
+
+    // Draw y-axis
+    chart_canvas_set_line_width(&canvas, 1);
+    chart_canvas_move_to(&canvas, 0.1 * w, 0.8 * h);
+    chart_canvas_line_to(&canvas, 0.1 * w, 0.2 * h);
+    chart_canvas_stroke(&canvas);
+
+    // Draw x-axis value at 100% mark
+    chart_canvas_set_color(&canvas, &self->text_color);
+    g_snprintf(value, sizeof(value), "%.1f", self->x_max);
+    chart_canvas_set_font_size(&canvas, 8.0 * (w/650));
+    chart_canvas_text_extents(&canvas, value, &extents);
+    chart_canvas_text(&canvas, 0.9 * w - extents.width/2, 0.16 * h, value);
+
+    // Draw x-axis value at 75% mark
+    g_snprintf(value, sizeof(value), "%.1f", (self->x_max/4) * 3);
+    chart_canvas_set_font_size(&canvas, 8.0 * (w/650));
+    chart_canvas_text_extents(&canvas, value, &extents);
+    chart_canvas_text(&canvas, 0.7 * w - extents.width/2, 0.16 * h, value);
+
+    // Draw x-axis value at 50% mark
+    g_snprintf(value, sizeof(value), "%.1f", self->x_max/2);
+    chart_canvas_set_font_size(&canvas, 8.0 * (w/650));
+    chart_canvas_text_extents(&canvas, value, &extents);
+    chart_canvas_text(&canvas, 0.5 * w - extents.width/2, 0.16 * h, value);
+
+    // Draw x-axis value at 25% mark
+    g_snprintf(value, sizeof(value), "%.1f", self->x_max/4);
+    chart_canvas_set_font_size(&canvas, 8.0 * (w/650));
+    chart_canvas_text_extents(&canvas, value, &extents);
+    chart_canvas_text(&canvas, 0.3 * w - extents.width/2, 0.16 * h, value);
+
+    // Draw x-axis value at 0% mark
+    g_snprintf(value, sizeof(value), "%.1f", self->x_min);
+    chart_canvas_set_font_size(&canvas, 8.0 * (w/650));
+    chart_canvas_text_extents(&canvas, "0", &extents);
+    chart_canvas_text(&canvas, 0.1 * w - extents.width/2, 0.16 * h, value);
+
+    // Draw y-axis value at 0% mark
+    g_snprintf(value, sizeof(value), "%.1f", self->y_min);
+    chart_canvas_set_font_size(&canvas, 8.0 * (w/650));
+    chart_canvas_text_extents(&canvas, value, &extents);
+    chart_canvas_text(&canvas, 0.091 * w - extents.width, 0.191 * h, value);
+
+    // Draw y-axis value at 25% mark
+    g_snprintf(value, sizeof(value), "%.1f", self->y_min + (self->y_max - self->y_min) * 0.25);
+    chart_canvas_set_font_size(&canvas, 8.0 * (w/650));
+    chart_canvas_text_extents(&canvas, value, &extents);
+    chart_canvas_text(&canvas, 0.091 * w - extents.width, 0.34 * h, value);
+
+    // Draw y-axis value at 50% mark
+    g_snprintf(value, sizeof(value), "%.1f", self->y_min + (self->y_max - self->y_min) * 0.5);
+    chart_canvas_set_font_size(&canvas, 8.0 * (w/650));
+    chart_canvas_text_extents(&canvas, value, &extents);
+    chart_canvas_text(&canvas, 0.091 * w - extents.width, 0.49 * h, value);
+
+    // Draw y-axis value at 75% mark
+    g_snprintf(value, sizeof(value), "%.1f", self->y_min + (self->y_max - self->y_min) * 0.75);
+    chart_canvas_set_font_size(&canvas, 8.0 * (w/650));
+    chart_canvas_text_extents(&canvas, value, &extents);
+    chart_canvas_text(&canvas, 0.091 * w - extents.width, 0.64 * h, value);
+
+    // Draw y-axis value at 100% mark
+    g_snprintf(value, sizeof(value), "%.1f", self->y_max);
+    chart_canvas_set_font_size(&canvas, 8.0 * (w/650));
+    chart_canvas_text_extents(&canvas, value, &extents);
+    chart_canvas_text(&canvas, 0.091 * w - extents.width, 0.79 * h, value);
+
+    // Draw grid x-line 25%
+    chart_canvas_set_color(&canvas, &self->grid_color);
+    chart_canvas_set_line_width(&canvas, 1);
+    chart_canvas_move_to(&canvas, 0.1 * w, 0.35 * h);
+    chart_canvas_line_to(&canvas, 0.9 * w, 0.35 * h);
+    chart_canvas_stroke(&canvas);
+
+    // Draw grid x-line 50%
+    chart_canvas_set_line_width(&canvas, 1);
+    chart_canvas_move_to(&canvas, 0.1 * w, 0.5 * h);
+    chart_canvas_line_to(&canvas, 0.9 * w, 0.5 * h);
+    chart_canvas_stroke(&canvas);
+
+    // Draw grid x-line 75%
+    chart_canvas_set_line_width(&canvas, 1);
+    chart_canvas_move_to(&canvas, 0.1 * w, 0.65 * h);
+    chart_canvas_line_to(&canvas, 0.9 * w, 0.65 * h);
+    chart_canvas_stroke(&canvas);
+
+    // Draw grid x-line 100%
+    chart_canvas_set_line_width(&canvas, 1);
+    chart_canvas_move_to(&canvas, 0.1 * w, 0.8 * h);
+    chart_canvas_line_to(&canvas, 0.9 * w, 0.8 * h);
+    chart_canvas_stroke(&canvas);
+
+    // Draw grid y-line 25%
+    chart_canvas_set_line_width(&canvas, 1);
+    chart_canvas_move_to(&canvas, 0.3 * w, 0.8 * h);
+    chart_canvas_line_to(&canvas, 0.3 * w, 0.2 * h);
+    chart_canvas_stroke(&canvas);
+
+    // Draw grid y-line 50%
+    chart_canvas_set_line_width(&canvas, 1);
+    chart_canvas_move_to(&canvas, 0.5 * w, 0.8 * h);
+    chart_canvas_line_to(&canvas, 0.5 * w, 0.2 * h);
+    chart_canvas_stroke(&canvas);
+
+    // Draw grid y-line 75%
+    chart_canvas_set_line_width(&canvas, 1);
+    chart_canvas_move_to(&canvas, 0.7 * w, 0.8 * h);
+    chart_canvas_line_to(&canvas, 0.7 * w, 0.2 * h);
+    chart_canvas_stroke(&canvas);
+
+    // Draw grid y-line 100%
+    chart_canvas_set_line_width(&canvas, 1);
+    chart_canvas_move_to(&canvas, 0.9 * w, 0.8 * h);
+    chart_canvas_line_to(&canvas, 0.9 * w, 0.2 * h);
+    chart_canvas_stroke(&canvas);
+
+    chart_canvas_end(&canvas);
+}
+
+// Replay cached axes layer, regenerated only when size, range, text, font or colors change
+static void chart_snapshot_axes(struct chart_state_t *self,
+                                GtkSnapshot *snapshot,
+                                float h,
+                                float w)
+{
+    struct chart_axes_key_t key;
+
+    if (self->export != NULL)
+    {
+        // Drawn once, nothing to cache
+        chart_draw_axes(self, snapshot, h, w);
+        return;
+    }
+
+    memset(&key, 0, sizeof(key));
+    key.w = w;
+    key.h = h;
+    key.x_min = self->x_min;
+    key.x_max = self->x_max;
+    key.y_min = self->y_min;
+    key.y_max = self->y_max;
+    key.text_color = self->text_color;
+    key.grid_color = self->grid_color;
+    key.axis_color = self->axis_color;
+    key.text_serial = self->text_serial;
+
+    if (!self->axes_valid || memcmp(&key, &self->axes_key, sizeof(key)) != 0)
+    {
+        GtkSnapshot *axes_snapshot = gtk_snapshot_new();
+
+        chart_draw_axes(self, axes_snapshot, h, w);
+
+        g_clear_pointer(&self->axes_node, gsk_render_node_unref);
+        self->axes_node = gtk_snapshot_free_to_node(axes_snapshot);
+        self->axes_key = key;
+        self->axes_valid = TRUE;
+    }
+
+    if (self->axes_node != NULL)
+    {
+        gtk_snapshot_append_node(snapshot, self->axes_node);
+    }
+}
+
+// Marker sprite and color of series
+static struct chart_marker_t * chart_series_marker(struct chart_state_t *self, unsigned int series, const GdkRGBA **color)
+{
+    if (series > 0)
+    {
+        struct chart_series_t *extra = g_slist_nth_data(self->series_list, series - 1);
+
+        *color = &extra->color;
+        return &extra->marker;
+    }
+
+    *color = &self->line_color;
+    return &self->marker;
+}
+
+// Set up plot of data points into canvas, origin at bottom left of plot area with y-axis up
+static void chart_plot_begin(struct chart_plot_t *plot,
+                             struct chart_state_t *self,
+                             struct chart_canvas_t *canvas,
+                             unsigned int series,
+                             double x_scale,
+                             double y_scale,
+                             double plot_width,
+                             double plot_height)
+{
+    const GdkRGBA *color;
+
+    memset(plot, 0, sizeof(*plot));
+    plot->self = self;
+    plot->canvas = canvas;
+    plot->series = series;
+    plot->marker = chart_series_marker(self, series, &color);
+    plot->x_origin = self->x_min;
+    plot->x_scale = x_scale;
+    plot->y_scale = y_scale;
+
+    // Reduce line to at most first/min/max/last per pixel column
+    plot->line.canvas = canvas;
+    plot->line.decimate = (self->type == GTK_CHART_TYPE_LINE &&
+                           self->downsample == GTK_CHART_DOWNSAMPLE_M4);
+    plot->line.bucket_width = 1.0;
+    plot->line.bucket = -1;
+
+    // LTTB selects among ring points only, older points are always reduced per bucket like M4
+    plot->summarize = (self->type == GTK_CHART_TYPE_LINE && self->downsample != GTK_CHART_DOWNSAMPLE_NONE);
+    if (self->downsample != GTK_CHART_DOWNSAMPLE_NONE && self->downsample_budget >= 4)
+    {
+        plot->line.bucket_width = MAX(plot_width / (self->downsample_budget / 4), 1.0);
+    }
+
+    chart_canvas_set_color(canvas, color);
+    chart_canvas_set_line_width(canvas, 2.0);
+
+    if (self->type == GTK_CHART_TYPE_SCATTER)
+    {
+        chart_marker_update(plot->marker, self->marker.shape, self->marker.size, color,
+                            canvas->scale, canvas->cr == NULL);
+
+        // Opaque stamps at the same pixel are indistinguishable, draw each pixel once
+        if (color->alpha >= 1.0)
+        {
+            plot->covered_width = (int) ceil(plot_width) + 1;
+            plot->covered_height = (int) ceil(plot_height) + 1;
+            plot->covered = g_malloc0(((size_t) plot->covered_width * plot->covered_height + 7) / 8);
+        }
+    }
+}
+
+// Plot points of index range [start, end)
+static void chart_plot_range(struct chart_plot_t *plot,
+                             const struct chart_ring_t *ring,
+                             size_t start,
+                             size_t end,
+                             double plot_width)
+{
+    struct chart_state_t *self = plot->self;
+
+    if (self->downsample == GTK_CHART_DOWNSAMPLE_LTTB)
+    {
+        // Select shape preserving subset of visible points
+        size_t budget = self->downsample_budget ? self->downsample_budget : (size_t) plot_width;
+        chart_lttb(ring, start, end, budget, plot);
+    }
+    else if (plot->line.decimate && plot->x_culled)
+    {
+        // Query summaries per pixel column instead of visiting every point
+        chart_line_columns(plot, ring, start, end, plot_width);
+    }
+    else
+    {
+        double x[CHART_PLOT_BATCH];
+        double y[CHART_PLOT_BATCH];
+
+        for (size_t i = start; i < end; i += CHART_PLOT_BATCH)
+        {
+            size_t count = MIN(end - i, CHART_PLOT_BATCH);
+
+            chart_ring_load(ring, plot->series, i, count, x, y);
+            chart_plot_points(plot, x, y, count);
+        }
+    }
+}
+
+static void chart_plot_end(struct chart_plot_t *plot)
+{
+    if (plot->self->type == GTK_CHART_TYPE_LINE)
+    {
+        chart_line_stroke(&plot->line);
+    }
+
+    g_clear_pointer(&plot->covered, g_free);
+}
+
+// Render points from data x onwards into strip surface, replacing what was there
+static void chart_strip_render(struct chart_state_t *self, double from)
+{
+    struct chart_strip_t *strip = &self->strip;
+    const struct chart_ring_t *ring = &self->points;
+    double width = ceil(strip->key.plot_width) + 1;
+    double height = strip->key.plot_height + 2 * CHART_STRIP_MARGIN;
+    double x_scale = strip->key.plot_width / strip->key.x_span;
+    double y_scale = strip->key.plot_height / (strip->key.y_max - strip->key.y_min);
+    double bucket_width = 1.0;
+
+    if (self->downsample == GTK_CHART_DOWNSAMPLE_M4 && self->downsample_budget >= 4)
+    {
+        bucket_width = MAX(strip->key.plot_width / (self->downsample_budget / 4), 1.0);
+    }
+
+    // Clear whole decimation columns so they are rebuilt from all their points
+    double column = MAX(floor((from - strip->x_origin) * x_scale / bucket_width) * bucket_width, 0);
+    if (column >= width)
+    {
+        return;
+    }
+
+    cairo_t *cr = cairo_create(strip->surface);
+    cairo_rectangle(cr, column, 0, width - column, height);
+    cairo_clip(cr);
+    cairo_set_operator(cr, CAIRO_OPERATOR_CLEAR);
+    cairo_paint(cr);
+    cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
+
+    struct chart_canvas_t canvas;
+    struct chart_plot_t plot;
+
+    chart_canvas_begin_cairo_data(&canvas, self, cr);
+    chart_canvas_translate(&canvas, 0, height - CHART_STRIP_MARGIN);
+    chart_canvas_scale(&canvas, 1, -1);
+
+    // Start early enough for strokes and markers of older points to repaint into cleared columns
+    double pad = (2.0 + self->marker.size) / x_scale;
+    size_t start = chart_ring_lower_bound(ring, 0, ring->count, strip->x_origin + column / x_scale - pad);
+    size_t end = chart_ring_upper_bound(ring, start, ring->count, strip->x_origin + width / x_scale);
+
+    start = (start > 0) ? start - 1 : 0;
+    end = MIN(end + 1, ring->count);
+
+    for (unsigned int s = 0; s < ring->n_series; s++)
+    {
+        chart_plot_begin(&plot, self, &canvas, s, x_scale, y_scale, strip->key.plot_width, strip->key.plot_height);
+        plot.x_origin = strip->x_origin;
+        plot.x_culled = TRUE;
+        chart_plot_mapped(&plot, &self->mapped, strip->x_origin + column / x_scale - pad, strip->x_origin + width / x_scale);
+        chart_plot_history(&plot, ring, strip->x_origin + column / x_scale - pad, strip->x_origin + width / x_scale);
+        chart_plot_range(&plot, ring, start, end, width);
+        chart_plot_end(&plot);
+    }
+
+    chart_canvas_end(&canvas);
+    cairo_destroy(cr);
+}
+
+// Bring strip surface up to date with viewport and data. Scrolling shifts already rasterized
+// columns and only renders exposed columns and new points, anything else redraws in full.
+// Returns FALSE when strip rendering does not apply to the current data.
+static gboolean chart_strip_update(struct chart_state_t *self, double plot_width, double plot_height)
+{
+    struct chart_strip_t *strip = &self->strip;
+    const struct chart_ring_t *ring = &self->points;
+    struct chart_strip_key_t key;
+
+    // Rendered columns depend on all points only for ordered data and local decimation
+    if (!chart_ring_is_monotonic(ring) || self->downsample == GTK_CHART_DOWNSAMPLE_LTTB)
+    {
+        return FALSE;
+    }
+
+    memset(&key, 0, sizeof(key));
+    key.plot_width = plot_width;
+    key.plot_height = plot_height;
+    key.scale = self->scale;
+    key.x_span = self->x_max - self->x_min;
+    key.y_min = self->y_min;
+    key.y_max = self->y_max;
+    key.color = self->line_color;
+    key.type = self->type;
+    key.downsample = self->downsample;
+    key.downsample_budget = self->downsample_budget;
+    key.marker_shape = self->marker.shape;
+    key.marker_size = self->marker.size;
+    key.series_serial = self->series_serial;
+    key.data_serial = self->data_serial;
+    key.disorder = ring->disorder;
+
+    // Scrolling moves both ends of the range, allow for rounding in the span
+    if (fabs(key.x_span - strip->key.x_span) <= fabs(key.x_span) * 1e-9)
+    {
+        key.x_span = strip->key.x_span;
+    }
+
+    double x_scale = plot_width / key.x_span;
+    int device_width = ((int) ceil(plot_width) + 1) * key.scale;
+    double from;
+
+    gboolean full = (strip->surface == NULL ||
+                     memcmp(&key, &strip->key, sizeof(key)) != 0 ||
+                     self->x_min < strip->x_origin ||
+                     ring->total < strip->total);
+
+    // Points dropped from ring and history may still be on screen
+    if (!full && chart_ring_oldest_seq(ring) != strip->first_seq)
+    {
+        double oldest_x = (chart_history_n_blocks(&ring->history) > 0) ?
+            chart_history_block(&ring->history, 0)->x_first :
+            (ring->count > 0) ? chart_ring_x(ring, chart_ring_slot(ring, 0)) : -G_MAXDOUBLE;
+
+        full = (oldest_x > strip->x_origin);
+    }
+
+    // Shift by whole device pixels, the sub pixel remainder is applied when compositing
+    long shift = full ? 0 : (long) floor((self->x_min - strip->x_origin) * x_scale * key.scale);
+    if (shift >= device_width)
+    {
+        full = TRUE;
+    }
+
+    if (full)
+    {
+        if (strip->surface == NULL ||
+            strip->key.scale != key.scale ||
+            ceil(strip->key.plot_width) != ceil(plot_width) ||
+            strip->key.plot_height != plot_height)
+        {
+            g_clear_pointer(&strip->surface, cairo_surface_destroy);
+            strip->surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
+                                                        device_width,
+                                                        (int) ceil(plot_height + 2 * CHART_STRIP_MARGIN) * key.scale);
+            cairo_surface_set_device_scale(strip->surface, key.scale, key.scale);
+        }
+        strip->key = key;
+        strip->x_origin = self->x_min;
+        from = -G_MAXDOUBLE;
+    }
+    else
+    {
+        if (shift > 0)
+        {
+            unsigned char *data = cairo_image_surface_get_data(strip->surface);
+            int stride = cairo_image_surface_get_stride(strip->surface);
+            int rows = cairo_image_surface_get_height(strip->surface);
+
+            cairo_surface_flush(strip->surface);
+            for (int row = 0; row < rows; row++)
+            {
+                unsigned char *line = data + (size_t) row * stride;
+                memmove(line, line + shift * 4, (size_t) (device_width - shift) * 4);
+            }
+            cairo_surface_mark_dirty(strip->surface);
+
+            strip->x_origin += shift / (x_scale * key.scale);
+        }
+
+        // Newly exposed columns on the right and columns touched by new points
+        from = strip->x_origin + (double) (device_width - shift) / key.scale / x_scale;
+        if (ring->total > strip->total)
+        {
+            from = MIN(from, strip->last_x);
+        }
+        if (shift == 0 && ring->total == strip->total)
+        {
+            return TRUE;
+        }
+    }
+
+    chart_strip_render(self, from);
+
+    strip->total = ring->total;
+    strip->first_seq = chart_ring_oldest_seq(ring);
+    strip->last_x = ring->count ? chart_ring_x(ring, chart_ring_slot(ring, ring->count - 1)) : strip->x_origin;
+
+    return TRUE;
+}
+
+#define CHART_TILE_MIN_WIDTH 64
+
+// Data layer split into columns of device pixels, rendered on the worker pool
+struct chart_tiles_t
+{
+    struct chart_state_t *self;
+    float w;
+    float h;
+    double plot_width;
+    double plot_height;
+    float x_scale;
+    float y_scale;
+    int scale;
+    int tile_width;         // Device pixel columns per tile
+    unsigned int n_tiles;
+    size_t start;           // Index range of ring to draw
+    size_t end;
+    gboolean x_culled;      // Ring is ordered, tiles find their points by binary search
+    double pad;             // Plot pixels strokes and markers reach beyond their point
+    double bucket_width;
+    size_t *indices;        // Unordered ring indices binned by tile, tile t from offsets[t]
+    size_t *offsets;
+};
+
+struct chart_tile_t
+{
+    struct chart_job_t job;
+    struct chart_tiles_t *tiles;
+    unsigned int index;
+    cairo_surface_t *surface;
+};
+
+// Chunk of unordered points to bin, counts first and then writes tile lists
+struct chart_tile_bin_t
+{
+    struct chart_job_t job;
+    struct chart_tiles_t *tiles;
+    size_t first;
+    size_t last;
+    gboolean fill;
+    size_t *counts;         // Points per tile, write positions when filling
+};
+
+static void chart_tile_bin_run(struct chart_job_t *job)
+{
+    struct chart_tile_bin_t *bin = (struct chart_tile_bin_t *) job;
+    const struct chart_tiles_t *tiles = bin->tiles;
+    struct chart_state_t *self = tiles->self;
+    const struct chart_ring_t *ring = &self->points;
+    double pad = tiles->pad * tiles->scale;
+
+    for (size_t i = bin->first; i < bin->last; i++)
+    {
+        double x = chart_ring_x(ring, chart_ring_slot(ring, i));
+
+        if (!(x >= self->x_min && x <= self->x_max))
+        {
+            continue;
+        }
+
+        // Points near a tile edge reach into its neighbour
+        double column = ((x - self->x_min) * tiles->x_scale + 0.1 * tiles->w) * tiles->scale;
+        unsigned int first = (unsigned int) CLAMP(floor((column - pad) / tiles->tile_width), 0, tiles->n_tiles - 1);
+        unsigned int last = (unsigned int) CLAMP(floor((column + pad) / tiles->tile_width), 0, tiles->n_tiles - 1);
+
+        for (unsigned int t = first; t <= last; t++)
+        {
+            if (bin->fill)
+            {
+                tiles->indices[bin->counts[t]++] = i;
+            }
+            else
+            {
+                bin->counts[t]++;
+            }
+        }
+    }
+}
+
+// Sort unordered points into per tile lists, keeping ring order within each tile
+static void chart_tiles_bin(struct chart_tiles_t *tiles)
+{
+    size_t n = tiles->end - tiles->start;
+    unsigned int n_chunks = (unsigned int) CLAMP(n / 65536, 1, chart_pool_n_threads());
+    size_t chunk = (n + n_chunks - 1) / n_chunks;
+    struct chart_tile_bin_t *bins = g_new0(struct chart_tile_bin_t, n_chunks);
+    size_t *counts = g_new0(size_t, (size_t) n_chunks * tiles->n_tiles);
+    size_t total = 0;
+
+    for (unsigned int c = 0; c < n_chunks; c++)
+    {
+        bins[c].job.run = chart_tile_bin_run;
+        bins[c].tiles = tiles;
+        bins[c].first = tiles->start + MIN(c * chunk, n);
+        bins[c].last = tiles->start + MIN((c + 1) * chunk, n);
+        bins[c].counts = &counts[(size_t) c * tiles->n_tiles];
+    }
+    chart_pool_run(bins, sizeof(*bins), n_chunks);
+
+    // Lists of tiles follow each other, chunks in order within a list
+    tiles->offsets = g_new(size_t, tiles->n_tiles + 1);
+    for (unsigned int t = 0; t < tiles->n_tiles; t++)
+    {
+        tiles->offsets[t] = total;
+        for (unsigned int c = 0; c < n_chunks; c++)
+        {
+            size_t count = bins[c].counts[t];
+
+            bins[c].counts[t] = total;
+            total += count;
+        }
+    }
+    tiles->offsets[tiles->n_tiles] = total;
+    tiles->indices = g_new(size_t, MAX(total, 1));
+
+    for (unsigned int c = 0; c < n_chunks; c++)
+    {
+        bins[c].fill = TRUE;
+    }
+    chart_pool_run(bins, sizeof(*bins), n_chunks);
+
+    g_free(counts);
+    g_free(bins);
+}
+
+static void chart_tile_run(struct chart_job_t *job)
+{
+    struct chart_tile_t *tile = (struct chart_tile_t *) job;
+    const struct chart_tiles_t *tiles = tile->tiles;
+    struct chart_state_t *self = tiles->self;
+    const struct chart_ring_t *ring = &self->points;
+    struct chart_canvas_t canvas;
+    struct chart_plot_t plot;
+    double tile_x = (double) tile->index * tiles->tile_width / tiles->scale;
+    cairo_t *cr = cairo_create(tile->surface);
+
+    // Data covered by tile, widened to whole decimation columns and the reach of strokes and markers
+    double left = tile_x - 0.1 * tiles->w;
+    double right = left + (double) cairo_image_surface_get_width(tile->surface) / tiles->scale;
+    double x_lo = self->x_min + (floor(left / tiles->bucket_width) * tiles->bucket_width - tiles->pad) / tiles->x_scale;
+    double x_hi = self->x_min + (ceil(right / tiles->bucket_width) * tiles->bucket_width + tiles->pad) / tiles->x_scale;
+    size_t start = tiles->start;
+    size_t end = tiles->end;
+
+    if (tiles->x_culled)
+    {
+        start = chart_ring_lower_bound(ring, tiles->start, tiles->end, x_lo);
+        end = chart_ring_upper_bound(ring, start, tiles->end, x_hi);
+        if (self->type == GTK_CHART_TYPE_LINE)
+        {
+            start = (start > tiles->start) ? start - 1 : start;
+            end = MIN(end + 1, tiles->end);
+        }
+    }
+    x_lo = MAX(x_lo, self->x_min);
+    x_hi = MIN(x_hi, self->x_max);
+
+    // Same coordinate system as the single threaded path, shifted to the tile
+    chart_canvas_begin_cairo_data(&canvas, self, cr);
+    chart_canvas_translate(&canvas, -tile_x, tiles->h);
+    chart_canvas_scale(&canvas, 1, -1);
+    chart_canvas_translate(&canvas, 0.1 * tiles->w, 0.2 * tiles->h);
+
+    if (tiles->x_culled && self->type == GTK_CHART_TYPE_LINE)
+    {
+        chart_canvas_clip_rect(&canvas, 0, 0, tiles->plot_width, tiles->plot_height);
+    }
+
+    for (unsigned int s = 0; s < ring->n_series; s++)
+    {
+        chart_plot_begin(&plot, self, &canvas, s, tiles->x_scale, tiles->y_scale, tiles->plot_width, tiles->plot_height);
+        plot.x_culled = tiles->x_culled;
+        if (x_lo <= x_hi)
+        {
+            chart_plot_mapped(&plot, &self->mapped, x_lo, x_hi);
+            chart_plot_history(&plot, ring, x_lo, x_hi);
+        }
+        if (tiles->indices != NULL)
+        {
+            for (size_t i = tiles->offsets[tile->index]; i < tiles->offsets[tile->index + 1]; i++)
+            {
+                chart_plot_ring_point(&plot, ring, tiles->indices[i]);
+            }
+        }
+        else
+        {
+            chart_plot_range(&plot, ring, start, end, tiles->plot_width);
+        }
+        chart_plot_end(&plot);
+    }
+
+    chart_canvas_end(&canvas);
+    cairo_destroy(cr);
+}
+
+// Rasterize data layer in tiles on the worker pool and composite them into canvas.
+// Returns FALSE when the data needs the single threaded path.
+static gboolean chart_tiles_draw(struct chart_state_t *self,
+                                 struct chart_canvas_t *canvas,
+                                 float w,
+                                 float h,
+                                 double plot_width,
+                                 double plot_height)
+{
+    const struct chart_ring_t *ring = &self->points;
+    struct chart_tiles_t tiles;
+
+    // LTTB selects points across the whole viewport
+    if (self->downsample == GTK_CHART_DOWNSAMPLE_LTTB)
+    {
+        return FALSE;
+    }
+
+    memset(&tiles, 0, sizeof(tiles));
+    if (chart_ring_is_monotonic(ring))
+    {
+        if (!chart_visible_range(self, &tiles.start, &tiles.end, &tiles.x_culled))
+        {
+            tiles.start = tiles.end = 0;
+        }
+    }
+    else if (self->type == GTK_CHART_TYPE_SCATTER)
+    {
+        // Binning tests x of every point, no need to scan for the visible range first
+        tiles.start = 0;
+        tiles.end = ring->count;
+        tiles.x_culled = FALSE;
+    }
+    else
+    {
+        // Unordered lines connect points across tiles
+        return FALSE;
+    }
+
+    if (tiles.start == tiles.end && chart_history_n_points(&ring->history) == 0 && self->mapped.count == 0)
+    {
+        return FALSE;
+    }
+
+    tiles.self = self;
+    tiles.w = w;
+    tiles.h = h;
+    tiles.plot_width = plot_width;
+    tiles.plot_height = plot_height;
+    tiles.x_scale = plot_width / (self->x_max - self->x_min);
+    tiles.y_scale = plot_height / (self->y_max - self->y_min);
+    tiles.scale = canvas->scale;
+    tiles.pad = 2.0 + self->marker.size;
+    tiles.bucket_width = 1.0;
+    if (self->downsample == GTK_CHART_DOWNSAMPLE_M4 && self->downsample_budget >= 4)
+    {
+        tiles.bucket_width = MAX(plot_width / (self->downsample_budget / 4), 1.0);
+    }
+
+    // A few tiles per thread balance points crowding in part of the plot
+    int n_columns = (int) ceil(w) * tiles.scale;
+    unsigned int n_tiles = (unsigned int) CLAMP(n_columns / CHART_TILE_MIN_WIDTH, 1, 4 * chart_pool_n_threads());
+    tiles.tile_width = (n_columns + n_tiles - 1) / n_tiles;
+    tiles.n_tiles = (n_columns + tiles.tile_width - 1) / tiles.tile_width;
+
+    // Tiles share marker sprites read-only
+    if (self->type == GTK_CHART_TYPE_SCATTER)
+    {
+        for (unsigned int s = 0; s < ring->n_series; s++)
+        {
+            const GdkRGBA *color;
+            struct chart_marker_t *marker = chart_series_marker(self, s, &color);
+
+            chart_marker_update(marker, self->marker.shape, self->marker.size, color, tiles.scale, FALSE);
+        }
+    }
+
+    if (!tiles.x_culled)
+    {
+        chart_tiles_bin(&tiles);
+    }
+
+    struct chart_tile_t *jobs = g_new0(struct chart_tile_t, tiles.n_tiles);
+
+    for (unsigned int t = 0; t < tiles.n_tiles; t++)
+    {
+        jobs[t].job.run = chart_tile_run;
+        jobs[t].tiles = &tiles;
+        jobs[t].index = t;
+        jobs[t].surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
+                                                     MIN(tiles.tile_width, n_columns - (int) t * tiles.tile_width),
+                                                     (int) ceil(h) * tiles.scale);
+        cairo_surface_set_device_scale(jobs[t].surface, tiles.scale, tiles.scale);
+    }
+
+    chart_pool_run(jobs, sizeof(*jobs), tiles.n_tiles);
+
+    for (unsigned int t = 0; t < tiles.n_tiles; t++)
+    {
+        chart_canvas_paint_surface(canvas, jobs[t].surface, (double) t * tiles.tile_width / tiles.scale, 0);
+        cairo_surface_destroy(jobs[t].surface);
+    }
+
+    g_free(jobs);
+    g_free(tiles.indices);
+    g_free(tiles.offsets);
+
+    return TRUE;
+}
+
+#define CHART_DENSITY_BATCH 256
+#define CHART_DENSITY_GRID_BUDGET (64 << 20)  // Bytes of count grids private to binning jobs
+
+// Visible points of all series binned into a grid of cells covering the plot area, row 0 at y max
+struct chart_density_t
+{
+    struct chart_state_t *self;
+    int n_cols;
+    int n_rows;
+    double x_scale;         // Cells per data unit
+    double y_scale;
+    size_t start;           // Index range of ring to bin
+    size_t end;
+    size_t mapped_start;    // Record range of mapped file to bin
+    size_t mapped_end;
+    guint32 **grids;        // Counts of each binning job, summed into the first
+    guint32 max;
+    cairo_surface_t *surface;
+};
+
+enum chart_density_phase_t
+{
+    CHART_DENSITY_BIN,
+    CHART_DENSITY_SUM,
+    CHART_DENSITY_COLOR
+};
+
+// Share of the data or of the grid rows processed by one job
+struct chart_density_job_t
+{
+    struct chart_job_t job;
+    struct chart_density_t *density;
+    enum chart_density_phase_t phase;
+    unsigned int index;
+    unsigned int n_jobs;
+    guint32 max;
+};
+
+// Count batch of points into grid. Cell indices are computed branch free so the first loop
+// vectorizes, points outside the grid or with NAN coordinates get index -1.
+static void chart_density_add(const struct chart_density_t *density,
+                              guint32 *grid,
+                              const double *x,
+                              const double *y,
+                              size_t n)
+{
+    gint32 cells[CHART_DENSITY_BATCH];
+    double x_min = density->self->x_min;
+    double y_max = density->self->y_max;
+    double n_cols = density->n_cols;
+    double n_rows = density->n_rows;
+
+    g_assert(n <= CHART_DENSITY_BATCH);
+
+    for (size_t i = 0; i < n; i++)
+    {
+        double column = (x[i] - x_min) * density->x_scale;
+        double row = (y_max - y[i]) * density->y_scale;
+        int inside = (column >= 0) & (column < n_cols) & (row >= 0) & (row < n_rows);
+
+        column = inside ? column : 0;
+        row = inside ? row : 0;
+        cells[i] = inside ? (gint32) row * density->n_cols + (gint32) column : -1;
+    }
+
+    for (size_t i = 0; i < n; i++)
+    {
+        if (cells[i] >= 0)
+        {
+            grid[cells[i]]++;
+        }
+    }
+}
+
+static void chart_density_bin(const struct chart_density_job_t *job)
+{
+    const struct chart_density_t *density = job->density;
+    struct chart_state_t *self = density->self;
+    const struct chart_ring_t *ring = &self->points;
+    const struct chart_mapped_t *mapped = &self->mapped;
+    guint32 *grid = density->grids[job->index];
+    double x[CHART_DENSITY_BATCH];
+    double y[CHART_DENSITY_BATCH];
+
+    // Mapped file and ring are split evenly between jobs
+    size_t n = density->mapped_end - density->mapped_start;
+    size_t first = density->mapped_start + n * job->index / job->n_jobs;
+    size_t last = density->mapped_start + n * (job->index + 1) / job->n_jobs;
+
+    for (size_t i = first; i < last; i += CHART_DENSITY_BATCH)
+    {
+        size_t count = MIN(last - i, CHART_DENSITY_BATCH);
+
+        for (unsigned int s = 0; s < mapped->n_series; s++)
+        {
+            for (size_t k = 0; k < count; k++)
+            {
+                x[k] = chart_mapped_value(mapped, i + k, 0);
+                y[k] = chart_mapped_value(mapped, i + k, s + 1);
+            }
+            chart_density_add(density, grid, x, y, count);
+        }
+    }
+
+    n = density->end - density->start;
+    first = density->start + n * job->index / job->n_jobs;
+    last = density->start + n * (job->index + 1) / job->n_jobs;
+
+    for (size_t i = first; i < last; i += CHART_DENSITY_BATCH)
+    {
+        size_t count = MIN(last - i, CHART_DENSITY_BATCH);
+
+        chart_ring_load(ring, 0, i, count, x, NULL);
+        for (unsigned int s = 0; s < ring->n_series; s++)
+        {
+            chart_ring_load(ring, s, i, count, NULL, y);
+            chart_density_add(density, grid, x, y, count);
+        }
+    }
+
+    // History blocks overlapping the viewport, taken in turns
+    const struct chart_history_t *history = &ring->history;
+    size_t n_blocks = chart_history_n_blocks(history);
+    double *block_x = NULL;
+    double *block_y = NULL;
+
+    for (size_t b = job->index; b < n_blocks; b += job->n_jobs)
+    {
+        const struct chart_history_block_t *block = chart_history_block(history, b);
+
+        if (block->x_max < self->x_min || block->x_min > self->x_max)
+        {
+            continue;
+        }
+
+        if (block_x == NULL)
+        {
+            block_x = g_new(double, CHART_HISTORY_BLOCK);
+            block_y = g_new(double, CHART_HISTORY_BLOCK);
+        }
+
+        chart_history_read(history, block, 0, block_x, NULL);
+        for (unsigned int s = 0; s < block->n_series; s++)
+        {
+            chart_history_read(history, block, s, NULL, block_y);
+            for (size_t i = 0; i < block->count; i += CHART_DENSITY_BATCH)
+            {
+                chart_density_add(density, grid, &block_x[i], &block_y[i], MIN(block->count - i, CHART_DENSITY_BATCH));
+            }
+        }
+    }
+
+    g_free(block_x);
+    g_free(block_y);
+}
+
+// Perceptually uniform color map from dark blue to yellow (viridis)
+static void chart_density_color(double value, guint8 rgb[3])
+{
+    static const guint8 anchors[][3] =
+    {
+        {  68,   1,  84 }, {  72,  40, 120 }, {  62,  74, 137 }, {  49, 104, 142 },
+        {  38, 130, 142 }, {  31, 158, 137 }, {  53, 183, 121 }, { 110, 206,  88 },
+        { 181, 222,  43 }, { 253, 231,  37 }
+    };
+    double position = CLAMP(value, 0, 1) * (G_N_ELEMENTS(anchors) - 1);
+    unsigned int i = MIN((unsigned int) position, G_N_ELEMENTS(anchors) - 2);
+    double t = position - i;
+
+    for (int c = 0; c < 3; c++)
+    {
+        rgb[c] = (guint8) round(anchors[i][c] + t * (anchors[i + 1][c] - anchors[i][c]));
+    }
+}
+
+static void chart_density_job_run(struct chart_job_t *job)
+{
+    struct chart_density_job_t *density_job = (struct chart_density_job_t *) job;
+    struct chart_density_t *density = density_job->density;
+    size_t row_cells = density->n_cols;
+    size_t first = row_cells * (density->n_rows * density_job->index / density_job->n_jobs);
+    size_t last = row_cells * (density->n_rows * (density_job->index + 1) / density_job->n_jobs);
+    guint32 *grid = density->grids[0];
+
+    switch (density_job->phase)
+    {
+        case CHART_DENSITY_BIN:
+            chart_density_bin(density_job);
+            break;
+
+        case CHART_DENSITY_SUM:
+            // Sum rows of job across grids
+            for (size_t i = first; i < last; i++)
+            {
+                guint32 count = grid[i];
+
+                for (unsigned int g = 1; g < density_job->n_jobs; g++)
+                {
+                    count += density->grids[g][i];
+                }
+                grid[i] = count;
+                density_job->max = MAX(density_job->max, count);
+            }
+            break;
+
+        case CHART_DENSITY_COLOR:
+        {
+            // Log scale keeps sparse cells visible next to dense clusters
+            guint32 lut[256];
+            double scale = 255 / log1p(density->max);
+            guint8 *data = cairo_image_surface_get_data(density->surface);
+            int stride = cairo_image_surface_get_stride(density->surface);
+
+            for (int i = 0; i < 256; i++)
+            {
+                guint8 rgb[3];
+
+                chart_density_color(i / 255.0, rgb);
+                lut[i] = 0xff000000u | (guint32) rgb[0] << 16 | (guint32) rgb[1] << 8 | rgb[2];
+            }
+
+            for (size_t i = first; i < last; i++)
+            {
+                guint32 *pixel = (guint32 *) (data + (i / row_cells) * stride) + i % row_cells;
+
+                *pixel = (grid[i] == 0) ? 0 : lut[(int) MIN(log1p(grid[i]) * scale, 255)];
+            }
+            break;
+        }
+    }
+}
+
+// Draw scatter data as color mapped point density, one pass over the data binned on the
+// worker pool and one image for the whole plot area
+static void chart_density_draw(struct chart_state_t *self,
+                               struct chart_canvas_t *canvas,
+                               float w,
+                               float h,
+                               double plot_width,
+                               double plot_height)
+{
+    const struct chart_ring_t *ring = &self->points;
+    const struct chart_mapped_t *mapped = &self->mapped;
+    struct chart_density_t density;
+    double cell = (double) self->density / canvas->scale;     // Cell size in logical pixels
+    gboolean x_culled;
+
+    memset(&density, 0, sizeof(density));
+    density.self = self;
+    density.n_cols = (int) floor(plot_width / cell) + 1;
+    density.n_rows = (int) floor(plot_height / cell) + 1;
+    density.x_scale = plot_width / cell / (self->x_max - self->x_min);
+    density.y_scale = plot_height / cell / (self->y_max - self->y_min);
+
+    if (!chart_visible_range(self, &density.start, &density.end, &x_culled))
+    {
+        density.start = density.end = 0;
+    }
+    density.mapped_start = chart_mapped_search(mapped, 0, mapped->count, self->x_min, FALSE);
+    density.mapped_end = chart_mapped_search(mapped, density.mapped_start, mapped->count, self->x_max, TRUE);
+
+    // Every job counts into a private grid, as many jobs as the grid budget allows
+    size_t n_cells = (size_t) density.n_cols * density.n_rows;
+    size_t n_points = (density.end - density.start) + (density.mapped_end - density.mapped_start) +
+                      chart_history_n_points(&ring->history);
+    unsigned int n_jobs = (unsigned int) CLAMP(CHART_DENSITY_GRID_BUDGET / (n_cells * sizeof(guint32)), 1,
+                                               chart_pool_n_threads());
+    n_jobs = (unsigned int) MIN(n_jobs, MAX(n_points / 65536, 1));
+
+    struct chart_density_job_t *jobs = g_new0(struct chart_density_job_t, n_jobs);
+
+    density.grids = g_new(guint32 *, n_jobs);
+    for (unsigned int j = 0; j < n_jobs; j++)
+    {
+        density.grids[j] = g_new0(guint32, n_cells);
+        jobs[j].job.run = chart_density_job_run;
+        jobs[j].density = &density;
+        jobs[j].index = j;
+        jobs[j].n_jobs = n_jobs;
+        jobs[j].phase = CHART_DENSITY_BIN;
+    }
+    chart_pool_run(jobs, sizeof(*jobs), n_jobs);
+
+    for (unsigned int j = 0; j < n_jobs; j++)
+    {
+        jobs[j].phase = CHART_DENSITY_SUM;
+    }
+    chart_pool_run(jobs, sizeof(*jobs), n_jobs);
+
+    for (unsigned int j = 0; j < n_jobs; j++)
+    {
+        density.max = MAX(density.max, jobs[j].max);
+    }
+
+    if (density.max > 0)
+    {
+        density.surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, density.n_cols, density.n_rows);
+        cairo_surface_set_device_scale(density.surface, 1 / cell, 1 / cell);
+        cairo_surface_flush(density.surface);
+
+        for (unsigned int j = 0; j < n_jobs; j++)
+        {
+            jobs[j].phase = CHART_DENSITY_COLOR;
+        }
+        chart_pool_run(jobs, sizeof(*jobs), n_jobs);
+        cairo_surface_mark_dirty(density.surface);
+
+        chart_canvas_clip_rect(canvas, 0.1 * w, 0.2 * h, plot_width, plot_height);
+        chart_canvas_paint_surface(canvas, density.surface, 0.1 * w, 0.2 * h);
+        cairo_surface_destroy(density.surface);
+    }
+
+    for (unsigned int j = 0; j < n_jobs; j++)
+    {
+        g_free(density.grids[j]);
+    }
+    g_free(density.grids);
+    g_free(jobs);
+}
+
+static void chart_draw_line_or_scatter(struct chart_state_t *self,
+                                       GtkSnapshot *snapshot,
+                                       float h,
+                                       float w)
+{
+    // Static layer
+    chart_snapshot_axes(self, snapshot, h, w);
+
+    // Set up drawing canvas for data layer
+    struct chart_canvas_t canvas;
+    chart_canvas_begin(&canvas, self, snapshot, w, h);
+
+    double plot_width = w - 2 * 0.1 * w;
+    double plot_height = h - 2 * 0.2 * h;
+
+    if (self->type == GTK_CHART_TYPE_SCATTER && self->density > 0)
+    {
+        chart_density_draw(self, &canvas, w, h, plot_width, plot_height);
+        chart_canvas_end(&canvas);
+        return;
+    }
+
+    if (self->strip.enabled && chart_strip_update(self, plot_width, plot_height))
+    {
+        // Composite rasterized data layer
+        double offset = (self->strip.x_origin - self->x_min) * plot_width / (self->x_max - self->x_min);
+
+        chart_canvas_clip_rect(&canvas, 0.1 * w, 0.2 * h - CHART_STRIP_MARGIN,
+                               plot_width, plot_height + 2 * CHART_STRIP_MARGIN);
+        chart_canvas_paint_surface(&canvas, self->strip.surface, 0.1 * w + offset, 0.2 * h - CHART_STRIP_MARGIN);
+        chart_canvas_end(&canvas);
+        return;
+    }
+
+    if (self->tiled && chart_tiles_draw(self, &canvas, w, h, plot_width, plot_height))
+    {
+        chart_canvas_end(&canvas);
+        return;
+    }
+
+    // Move coordinate system to bottom left
+    chart_canvas_translate(&canvas, 0, h);
+
+    // Invert y-axis
+    chart_canvas_scale(&canvas, 1, -1);
+
+    // Move coordinate system to (0,0) of drawn coordinate system
+    chart_canvas_translate(&canvas, 0.1 * w, 0.2 * h);
+
+    // Calc scales with min values taken into account
+    float x_scale = plot_width / (self->x_max - self->x_min);
+    float y_scale = plot_height / (self->y_max - self->y_min);
+
+    // Draw data points from ring buffer, oldest first
+    const struct chart_ring_t *ring = &self->points;
+    struct chart_plot_t plot;
+    size_t start, end;
+    gboolean x_culled;
+
+    if (!chart_visible_range(self, &start, &end, &x_culled))
+    {
+        if (chart_history_n_points(&ring->history) == 0 && self->mapped.count == 0)
+        {
+            chart_canvas_end(&canvas);
+            return;
+        }
+        start = end = 0;
+    }
+
+    if (x_culled && self->type == GTK_CHART_TYPE_LINE)
+    {
+        // Clip segments to the points just outside the viewport at the plot edges
+        chart_canvas_clip_rect(&canvas, 0, 0, plot_width, plot_height);
+    }
+
+    // All series share the visible index range, mapped file and older points kept in history come first
+    for (unsigned int s = 0; s < ring->n_series; s++)
+    {
+        chart_plot_begin(&plot, self, &canvas, s, x_scale, y_scale, plot_width, plot_height);
+        plot.x_culled = x_culled;
+        chart_plot_mapped(&plot, &self->mapped, self->x_min, self->x_max);
+        chart_plot_history(&plot, ring, self->x_min, self->x_max);
+        chart_plot_range(&plot, ring, start, end, plot_width);
+        chart_plot_end(&plot);
+    }
+
+    chart_canvas_end(&canvas);
+}
+
+static void chart_draw_number(struct chart_state_t *self,
+                              GtkSnapshot *snapshot,
+                              float h,
+                              float w)
+{
+    cairo_text_extents_t extents;
+    char value[20];
+
+    // Assume aspect ratio w:h = 1:1
+
+    // Set up drawing canvas
+    struct chart_canvas_t canvas;
+    chart_canvas_begin(&canvas, self, snapshot, w, h);
+    chart_canvas_set_color(&canvas, &self->text_color);
+
+    // Move coordinate system to bottom left
+    chart_canvas_translate(&canvas, 0, h);
+
+    // Invert y-axis
+    chart_canvas_scale(&canvas, 1, -1);
+
+    // Draw title
+    double title_font_size = 0.05 * h;  // 5% of total height
+    chart_canvas_set_font_size(&canvas, title_font_size);
+    chart_canvas_text_extents(&canvas, self->title, &extents);
+    chart_canvas_text(&canvas, 0.5 * w - extents.width/2, 0.9 * h - extents.height/2, self->title);
+
+    // Draw label
+    chart_canvas_set_font_size(&canvas, 25.0 * (w/650));
+    chart_canvas_text_extents(&canvas, self->label, &extents);
+    chart_canvas_text(&canvas, 0.5 * w - extents.width/2, 0.2 * h - extents.height/2, self->label);
+
+    // Draw number
+    g_snprintf(value, sizeof(value), "%.1f", self->value);
+    chart_canvas_set_font_size(&canvas, 140.0 * (w/650));
+    chart_canvas_text_extents(&canvas, value, &extents);
+    chart_canvas_text(&canvas, 0.5 * w - extents.width/2, 0.5 * h - extents.height/2, value);
+
+    chart_canvas_end(&canvas);
+}
+
+static void chart_draw_gauge_linear(struct chart_state_t *self,
+                                    GtkSnapshot *snapshot,
+                                    float h,
+                                    float w)
+{
+    cairo_text_extents_t extents;
+    char value[20];
+
+    // Assume aspect ratio w:h = 1:2
+
+    // Set up drawing canvas
+    struct chart_canvas_t canvas;
+    chart_canvas_begin(&canvas, self, snapshot, w, h);
+    chart_canvas_set_color(&canvas, &self->text_color);
+
+    // Move coordinate system to bottom left
+    chart_canvas_translate(&canvas, 0, h);
+
+    // Invert y-axis
+    chart_canvas_scale(&canvas, 1, -1);
+
+    // Draw title
+    double title_font_size = 0.05 * h;  // 5% of total height
+    chart_canvas_set_font_size(&canvas, title_font_size);
+    chart_canvas_text_extents(&canvas, self->title, &extents);
+    chart_canvas_text(&canvas, 0.5 * w - extents.width/2, 0.95 * h - extents.height/2, self->title);
+
+    // Draw label
+    chart_canvas_set_font_size(&canvas, 25.0 * (w/650));
+    chart_canvas_text_extents(&canvas, self->label, &extents);
+    chart_canvas_text(&canvas, 0.5 * w - extents.width/2, 0.05 * h - extents.height/2, self->label);
+
+    // Draw minimum value
+    g_snprintf(value, sizeof(value), "%.0f", self->value_min);
+    chart_canvas_set_font_size(&canvas, 25.0 * (w/650));
+    chart_canvas_text_extents(&canvas, value, &extents);
+    chart_canvas_text(&canvas, 0.7 * w, 0.1 * h - extents.height/2, value);
+
+    // Draw maximum value
+    g_snprintf(value, sizeof(value), "%.0f", self->value_max);
+    chart_canvas_set_font_size(&canvas, 25.0 * (w/650));
+    chart_canvas_text_extents(&canvas, value, &extents);
+    chart_canvas_text(&canvas, 0.7 * w, 0.9 * h - extents.height/2, value);
+
+    // Draw minimum line
+    chart_canvas_set_color(&canvas, &self->axis_color);
+    chart_canvas_move_to(&canvas, 0.375 * w, 0.1 * h);
+    chart_canvas_line_to(&canvas, 0.625 * w, 0.1 * h);
+    chart_canvas_set_line_width(&canvas, 1);
+    chart_canvas_stroke(&canvas);
+
+    // Draw maximum line
+    chart_canvas_move_to(&canvas, 0.375 * w, 0.9 * h);
+    chart_canvas_line_to(&canvas, 0.625 * w, 0.9 * h);
+    chart_canvas_set_line_width(&canvas, 1);
+    chart_canvas_stroke(&canvas);
+
+    // Move coordinate system to (0,0) of gauge line start
+    chart_canvas_translate(&canvas, 0.5 * w, 0.1 * h);
+
+    // Draw gauge line
+    chart_canvas_set_color(&canvas, &self->line_color);
+    chart_canvas_move_to(&canvas, 0, 0);
+    float y_scale = (h - 2 * 0.1 * h) / self->value_max;
+    chart_canvas_set_line_width(&canvas, 0.2 * w);
+    chart_canvas_line_to(&canvas, 0, self->value * y_scale);
+    chart_canvas_stroke(&canvas);
+
+    chart_canvas_end(&canvas);
+}
+
+static void chart_draw_gauge_angular(struct chart_state_t *self,
+                                     GtkSnapshot *snapshot,
+                                     float h,
+                                     float w)
+{
+    cairo_text_extents_t extents;
+    char value[20];
+
+    // Assume aspect ratio w:h = 1:1
+
+    // Set up drawing canvas
+    struct chart_canvas_t canvas;
+    chart_canvas_begin(&canvas, self, snapshot, w, h);
+    chart_canvas_set_color(&canvas, &self->text_color);
+
+    // Move coordinate system to bottom left
+    chart_canvas_translate(&canvas, 0, h);
+
+    // Invert y-axis
+    chart_canvas_scale(&canvas, 1, -1);
+
+    // Draw title
+    double title_font_size = 0.05 * h;  // 5% of total height
+    chart_canvas_set_font_size(&canvas, title_font_size);
+    chart_canvas_text_extents(&canvas, self->title, &extents);
+    chart_canvas_text(&canvas, 0.5 * w - extents.width/2, 0.9 * h - extents.height/2, self->title);
+
+    // Draw label
+    chart_canvas_set_font_size(&canvas, 25.0 * (w/650));
+    chart_canvas_text_extents(&canvas, self->label, &extents);
+    chart_canvas_text(&canvas, 0.5 * w - extents.width/2, 0.1 * h - extents.height/2, self->label);
+
+    // Draw minimum value
+    g_snprintf(value, sizeof(value), "%.0f", self->value_min);
+    chart_canvas_set_font_size(&canvas, 25.0 * (w/650));
+    chart_canvas_text_extents(&canvas, value, &extents);
+    chart_canvas_text(&canvas, 0.225 * w, 0.25 * h - extents.height/2, value);
+
+    // Draw maximum value
+    g_snprintf(value, sizeof(value), "%.0f", self->value_max);
+    chart_canvas_set_font_size(&canvas, 25.0 * (w/650));
+    chart_canvas_text_extents(&canvas, value, &extents);
+    chart_canvas_text(&canvas, 0.77 * w - extents.width, 0.25 * h - extents.height/2, value);
+
+    // Draw minimum line
+    chart_canvas_set_color(&canvas, &self->axis_color);
+    chart_canvas_move_to(&canvas, 0.08 * w, 0.25 * h);
+    chart_canvas_line_to(&canvas, 0.22 * w, 0.25 * h);
+    chart_canvas_set_line_width(&canvas, 1);
+    chart_canvas_stroke(&canvas);
+
+    // Draw maximum line
+    chart_canvas_move_to(&canvas, 0.78 * w, 0.25 * h);
+    chart_canvas_line_to(&canvas, 0.92 * w, 0.25 * h);
+    chart_canvas_set_line_width(&canvas, 1);
+    chart_canvas_stroke(&canvas);
+
+    // Re-invert y-axis
+    chart_canvas_scale(&canvas, 1, -1);
+
+    // Draw arc
+    chart_canvas_set_color(&canvas, &self->line_color);
+    double xc = 0.5 * w;
+    double yc = -0.25 * h;
+    double radius = 0.35 * w;
+    double angle1 = 180 * (M_PI/180.0);
+    double angle = self->value * (180 / (self->value_max));
+    double angle2 = 180 * (M_PI/180.0) + angle * (M_PI/180.0);
+    chart_canvas_set_line_width(&canvas, 0.1 * w);
+    chart_canvas_arc(&canvas, xc, yc, radius, angle1, angle2);
+    chart_canvas_stroke(&canvas);
+
+    chart_canvas_end(&canvas);
+}
+
+static void chart_draw_pie(struct chart_state_t *self,
+                                     GtkSnapshot *snapshot,
+                                     float h,
+                                     float w)
+{
+    cairo_text_extents_t extents;
+
+    // Set up drawing canvas
+    struct chart_canvas_t canvas;
+    chart_canvas_begin(&canvas, self, snapshot, w, h);
+
+    // Center of chart
+    double cx = w / 2.0;
+    double cy = h / 2.0;
+
+    double radius = MIN(w, h) / 2.5; // margin
+
+    double total = 0.0;
+    GSList *l;
+    for(l = self->slice_list; l != NULL; l = l->next)
+    {
+        struct chart_slice_t *slice = l->data;
+        total += slice->value;
+    }
+
+    if(total <= 0.0)
+    {
+        chart_canvas_end(&canvas);
+        return;
+    }
+
+    double start_angle = 0.0;
+
+    for (l = self->slice_list; l != NULL; l = l->next)
+    {
+        struct chart_slice_t *slice = l->data;
+
+        // Angle of the slice proportional to its value
+        double slice_angle = (slice->value / total) * 2.0 * G_PI;
+
+        chart_canvas_set_rgba(&canvas, slice->color.red, slice->color.green, slice->color.blue, slice->color.alpha);
+
+        chart_canvas_move_to(&canvas, w / 2, h / 2);
+        chart_canvas_arc(&canvas, w / 2, h / 2, radius, start_angle, start_angle + slice_angle);
+        chart_canvas_close_path(&canvas);
+        chart_canvas_fill(&canvas);
+
+        if(slice->label != NULL) {
+            double middle = start_angle + slice_angle / 2.0;
+            double distance = radius + 20; // Position outside of the slide radius
+
+            double lx = cx + cos(middle) * distance; // X = cx + cos(0) * radius
+            double ly = cy + sin(middle) * distance; // Y = cy + cos(0) * radius
+
+            chart_canvas_set_rgba(&canvas, slice->color.red, slice->color.green, slice->color.blue, slice->color.alpha);
+            chart_canvas_set_font_size(&canvas, 12);
+            chart_canvas_text_extents(&canvas, slice->label, &extents);
+
+            // Adjust x position if angle is between 90º (PI/2) and 270º (3PI/2)
+            if(middle > G_PI / 2 && middle < 3 * G_PI / 2)
+            {
+                lx -= extents.width;
+            }
+
+            chart_canvas_text(&canvas, lx, ly, slice->label);
+        }
+
+        start_angle += slice_angle;
+    }
+
+    chart_canvas_set_color(&canvas, &self->text_color);
+
+    // Move coordinate system to bottom left
+    chart_canvas_translate(&canvas, 0, h);
+
+    // Invert y-axis
+    chart_canvas_scale(&canvas, 1, -1);
+
+    // Draw title
+    chart_canvas_set_font_size(&canvas, MIN(w, h) / 20);
+    chart_canvas_text_extents(&canvas, self->title, &extents);
+    chart_canvas_text(&canvas, 0.5 * w - extents.width/2, 0.95 * h - extents.height/2, self->title);
+
+    chart_canvas_end(&canvas);
+}
+
+static void chart_draw_column(struct chart_state_t *self,
+                              GtkSnapshot *snapshot,
+                              float h,
+                              float w)
+{
+    cairo_text_extents_t extents;
+
+    // Set up drawing canvas
+    struct chart_canvas_t canvas;
+    chart_canvas_begin(&canvas, self, snapshot, w, h + 40);
+
+    int n_total = g_slist_length(self->column_list);
+    if(n_total == 0) {
+        chart_canvas_end(&canvas);
+        return;
+    }
+
+    float spacing = (w * 0.05) * (n_total + 1);
+    float column_width = (w - spacing) / n_total;
+
+    double max_value = 0.0;
+    GSList *l;
+    for(l = self->column_list; l != NULL; l = l->next)
+    {
+        struct chart_column_t *column = l->data;
+        if (column->value > max_value) max_value = column->value;
+    }
+
+    if(max_value <= 0.0)
+    {
+        chart_canvas_end(&canvas);
+        return;
+    }
+
+    float y_scale = (h - (0.1 * h) - (0.1 * h)) / max_value;
+    int i = 0;
+
+    double ticks = max_value / self->ticks;
+
+    for(int i = 0; i <= self->ticks; i++)
+    {
+        double value = i * ticks;
+        float y_tick = h - 0.1 * h - value * y_scale;
+
+        char label[64];
+        snprintf(label, sizeof(label), "%.0f", value);
+
+        // Draw ticks value
+        chart_canvas_set_rgba(&canvas, 0.6, 0.6, 0.6, 0.8);
+        chart_canvas_set_font_size(&canvas, 12);
+
+        chart_canvas_text(&canvas, 5, y_tick, label);
+
+        // Draw line horizontal
+        chart_canvas_set_rgba(&canvas, 0.6, 0.6, 0.6, 0.3);
+        chart_canvas_move_to(&canvas, 30, y_tick);
+        chart_canvas_line_to(&canvas, w, y_tick);
+        chart_canvas_stroke(&canvas);
+    }
+
+    for (l = self->column_list; l != NULL; l = l->next)
+    {
+        struct chart_column_t *column = l->data;
+
+
+        float column_height = column->value * y_scale;
+        if(column_height < 2.0f) { // value = 0
+            column_height = 2.0f;
+        }
+
+        float x = (w * 0.05) + i * (column_width + (w * 0.05));
+        float y = h - (0.1 * h) - column_height;
+        i++;
+
+        // Draw Column
+        chart_canvas_set_rgba(&canvas, column->color.red, column->color.green, column->color.blue, column->color.alpha);
+
+        chart_canvas_fill_rect(&canvas, x, y, column_width, column_height);
+
+        if(column->label != NULL) {
+            // Draw Label
+            chart_canvas_set_rgba(&canvas, 0.6, 0.6, 0.6, 0.8);
+            chart_canvas_set_font_size(&canvas, 12);
+            chart_canvas_text_extents(&canvas, column->label, &extents);
+
+            float label_x = x + column_width / 2;
+            float label_y = h - (w * 0.03) + 20;
+
+            chart_canvas_save(&canvas);
+            chart_canvas_translate(&canvas, label_x, label_y);
+            chart_canvas_rotate(&canvas, -M_PI / 3); // rotate -60º (-PI/3)
+
+            chart_canvas_text(&canvas, -extents.width / 2, -extents.height, column->label);
+            chart_canvas_restore(&canvas);
+        }
+    }
+
+    chart_canvas_set_color(&canvas, &self->text_color);
+
+    // Move coordinate system to bottom left
+    chart_canvas_translate(&canvas, 0, h);
+
+    // Invert y-axis
+    chart_canvas_scale(&canvas, 1, -1);
+
+    // Draw title
+    chart_canvas_set_font_size(&canvas, MIN(w, h) / 20);
+    chart_canvas_text_extents(&canvas, self->title, &extents);
+    chart_canvas_text(&canvas, 0.5 * w - extents.width/2, 0.95 * h - extents.height/2, self->title);
+
+    chart_canvas_end(&canvas);
+}
+
+static void chart_draw_unknown_type(struct chart_state_t *self,
+                                    GtkSnapshot *snapshot,
+                                    float h,
+                                    float w)
+{
+    UNUSED(self);
+
+    cairo_text_extents_t extents;
+    const char *warning = "Unknown chart type";
+
+    // Set up drawing canvas
+    struct chart_canvas_t canvas;
+    chart_canvas_begin(&canvas, self, snapshot, w, h);
+    chart_canvas_set_color(&canvas, &self->text_color);
+
+    // Move coordinate system to bottom left
+    chart_canvas_translate(&canvas, 0, h);
+
+    // Invert y-axis
+    chart_canvas_scale(&canvas, 1, -1);
+
+    // Draw title
+    double title_font_size = 0.05 * h;  // 5% of total height
+    chart_canvas_set_font_size(&canvas, title_font_size);
+    chart_canvas_text_extents(&canvas, warning, &extents);
+    chart_canvas_text(&canvas, 0.5 * w - extents.width/2, 0.5 * h - extents.height/2, warning);
+
+    chart_canvas_end(&canvas);
+}
+
+
+// Automatically update colors if none set
+static void chart_resolve_colors(GtkChart *self)
+{
+    GtkStyleContext *context = gtk_widget_get_style_context(&self->parent_instance);
+    if (self->state.text_color.alpha == -1.0)
+    {
+        gtk_style_context_get_color(context, &self->state.text_color);
+    }
+    if (self->state.line_color.alpha == -1.0)
+    {
+        gtk_style_context_lookup_color (context, "theme_selected_bg_color", &self->state.line_color);
+    }
+    if (self->state.grid_color.alpha == -1.0)
+    {
+        gtk_style_context_get_color(context, &self->state.grid_color);
+        self->state.grid_color.alpha = 0.1;
+    }
+    if (self->state.axis_color.alpha == -1.0)
+    {
+        gtk_style_context_get_color(context, &self->state.axis_color);
+    }
+}
+
+static void chart_draw(struct chart_state_t *self, GtkSnapshot *snapshot, float height, float width)
+{
+    // Draw various chart types
+    switch (self->type)
+    {
+        case GTK_CHART_TYPE_LINE:
+        case GTK_CHART_TYPE_SCATTER:
+            chart_draw_line_or_scatter(self, snapshot, height, width);
+            break;
+
+        case GTK_CHART_TYPE_NUMBER:
+            chart_draw_number(self, snapshot, height, width);
+            break;
+
+        case GTK_CHART_TYPE_GAUGE_LINEAR:
+            chart_draw_gauge_linear(self, snapshot, height, width);
+            break;
+
+        case GTK_CHART_TYPE_GAUGE_ANGULAR:
+            chart_draw_gauge_angular(self, snapshot, height, width);
+            break;
+
+        case GTK_CHART_TYPE_PIE:
+            chart_draw_pie(self, snapshot, height, width);
+            break;
+
+        case GTK_CHART_TYPE_COLUMN:
+            chart_draw_column(self, snapshot, height, width);
+            break;
+
+        default:
+            chart_draw_unknown_type(self, snapshot, height, width);
+            break;
+    }
+}
+
+static void gtk_chart_snapshot (GtkWidget   *widget,
+                                GtkSnapshot *snapshot)
+{
+    GtkChart *self = GTK_CHART(widget);
+
+    float width = gtk_widget_get_width (widget);
+    float height = gtk_widget_get_height (widget);
+
+    chart_resolve_colors(self);
+    self->state.scale = gtk_widget_get_scale_factor(widget);
+    self->state.pango_context = gtk_widget_get_pango_context(widget);
+    chart_draw(&self->state, snapshot, height, width);
+    self->state.pango_context = NULL;
+
+    // Pending data changes are now on screen
+    self->dirty = FALSE;
+
+    self->snapshot = snapshot;
+}
+
+static void gtk_chart_system_setting_changed (GtkWidget *widget, GtkSystemSetting setting)
+{
+    GtkChart *self = GTK_CHART(widget);
+
+    // Font or scale changes invalidate shaped text
+    self->state.text_serial++;
+    chart_text_cache_clear(&chart_text_cache);
+
+    GTK_WIDGET_CLASS (gtk_chart_parent_class)->system_setting_changed (widget, setting);
+}
+
+static void gtk_chart_class_init (GtkChartClass *class)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS (class);
+    GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (class);
+
+    object_class->finalize = gtk_chart_finalize;
+    object_class->dispose = gtk_chart_dispose;
+
+    widget_class->snapshot = gtk_chart_snapshot;
+    widget_class->system_setting_changed = gtk_chart_system_setting_changed;
+}
+
+EXPORT GtkWidget * gtk_chart_new (void)
+{
+
+    return g_object_new (GTK_TYPE_CHART, NULL);
+}
+
+EXPORT void gtk_chart_set_user_data(GtkChart *chart, void *user_data)
+{
+    chart->user_data = user_data;
+}
+
+EXPORT void * gtk_chart_get_user_data(GtkChart *chart)
+{
+    return chart->user_data;
+}
+
+EXPORT void gtk_chart_set_type(GtkChart *chart, GtkChartType type)
+{
+    chart->state.type = type;
+}
+
+EXPORT void gtk_chart_set_title(GtkChart *chart, const char *title)
+{
+
+    g_assert_nonnull(chart);
+    g_assert_nonnull(title);
+
+    if (chart->state.title != NULL)
+    {
+        g_free(chart->state.title);
+    }
+
+    chart->state.title = g_strdup(title);
+    chart->state.text_serial++;
+}
+
+EXPORT void gtk_chart_set_label(GtkChart *chart, const char *label)
+{
+    g_assert_nonnull(chart);
+    g_assert_nonnull(label);
+
+    if (chart->state.label != NULL)
+    {
+        g_free(chart->state.label);
+    }
+
+    chart->state.label = g_strdup(label);
+}
+
+EXPORT void gtk_chart_set_x_label(GtkChart *chart, const char *x_label)
+{
+    g_assert_nonnull(chart);
+    g_assert_nonnull(x_label);
+
+    if (chart->state.x_label != NULL)
+    {
+        g_free(chart->state.x_label);
+    }
+
+    chart->state.x_label = g_strdup(x_label);
+    chart->state.text_serial++;
+}
+
+EXPORT void gtk_chart_set_y_label(GtkChart *chart, const char *y_label)
+{
+    g_assert_nonnull(chart);
+    g_assert_nonnull(y_label);
+
+    if (chart->state.y_label != NULL)
+    {
+        g_free(chart->state.y_label);
+    }
+
+    chart->state.y_label = g_strdup(y_label);
+    chart->state.text_serial++;
+}
+
+EXPORT void gtk_chart_set_x_max(GtkChart *chart, double x_max)
+{
+    chart->state.x_max = x_max;
+}
+
+EXPORT void gtk_chart_set_y_max(GtkChart *chart, double y_max)
+{
+    chart->state.y_max = y_max;
+}
+
+EXPORT void gtk_chart_set_x_min(GtkChart *chart, double x_min)
+{
+    chart->state.x_min = x_min;
+}
+
+EXPORT void gtk_chart_set_y_min(GtkChart *chart, double y_min)
+{
+    chart->state.y_min = y_min;
+}
+
+EXPORT void gtk_chart_set_width(GtkChart *chart, int width)
+{
+    chart->state.width = width;
+}
+
+EXPORT void gtk_chart_plot_point(GtkChart *chart, double x, double y)
+{
+    // Add point to ring buffer to be drawn
+    chart_ring_push(&chart->state.points, x, &y, 1);
+    chart->state.point_list_stale = TRUE;
+
+    // Mark widget dirty, redrawn on next frame clock tick
+    chart_queue_redraw(chart);
+}
+
+EXPORT void gtk_chart_plot_points(GtkChart *chart, const double *xs, const double *ys, size_t n)
+{
+    g_assert_nonnull(chart);
+
+    if (n == 0)
+    {
+        return;
+    }
+
+    g_assert_nonnull(xs);
+    g_assert_nonnull(ys);
+
+    // Copy block into ring buffer
+    chart_ring_push_block(&chart->state.points, xs, &ys, 1, n);
+    chart->state.point_list_stale = TRUE;
+
+    // Mark widget dirty, redrawn on next frame clock tick
+    chart_queue_redraw(chart);
+}
+
+EXPORT void gtk_chart_plot_points_strided(GtkChart *chart,
+                                          const double *xs, size_t x_stride,
+                                          const double *ys, size_t y_stride,
+                                          size_t n)
+{
+    g_assert_nonnull(chart);
+
+    if (n == 0)
+    {
+        return;
+    }
+
+    g_assert_nonnull(xs);
+    g_assert_nonnull(ys);
+
+    if (x_stride == 1 && y_stride == 1)
+    {
+        chart_ring_push_block(&chart->state.points, xs, &ys, 1, n);
+    }
+    else
+    {
+        chart_ring_push_strided(&chart->state.points, xs, x_stride, ys, y_stride, n);
+    }
+    chart->state.point_list_stale = TRUE;
+
+    // Mark widget dirty, redrawn on next frame clock tick
+    chart_queue_redraw(chart);
+}
+
+EXPORT void gtk_chart_plot_points_interleaved(GtkChart *chart, const double *xy, size_t n)
+{
+    g_assert_nonnull(chart);
+
+    if (n == 0)
+    {
+        return;
+    }
+
+    g_assert_nonnull(xy);
+
+    gtk_chart_plot_points_strided(chart, &xy[0], 2, &xy[1], 2, n);
+}
+
+EXPORT void gtk_chart_set_storage(GtkChart *chart, GtkChartStorage storage)
+{
+    struct chart_ring_t *ring = &chart->state.points;
+
+    g_assert_nonnull(chart);
+
+    if (storage == ring->storage)
+    {
+        return;
+    }
+
+    // Convert stored points, history moves onto the uniform x grid along with the ring
+    chart_ring_convert(ring, storage, ring->y_offset, ring->y_step);
+    if (chart_storage_is_uniform(storage))
+    {
+        chart_ring_rebase_history(ring);
+    }
+    chart->state.point_list_stale = TRUE;
+    chart->state.data_serial++;
+
+    chart_queue_redraw(chart);
+}
+
+EXPORT GtkChartStorage gtk_chart_get_storage(GtkChart *chart)
+{
+    return chart->state.points.storage;
+}
+
+EXPORT void gtk_chart_set_uniform_x(GtkChart *chart, double start, double step)
+{
+    struct chart_ring_t *ring = &chart->state.points;
+
+    g_assert_nonnull(chart);
+    g_return_if_fail(step > 0);
+
+    // Next plotted point is at start. Stored points, including those kept in history,
+    // move onto the new grid so they stay evenly spaced right before it.
+    ring->x_start = start;
+    ring->x_step = step;
+    ring->x_base = ring->total;
+
+    if (chart_storage_is_uniform(ring->storage))
+    {
+        chart_ring_rebase_history(ring);
+        chart->state.point_list_stale = TRUE;
+        chart->state.data_serial++;
+        chart_queue_redraw(chart);
+    }
+}
+
+EXPORT void gtk_chart_set_int16_scale(GtkChart *chart, double offset, double step)
+{
+    struct chart_ring_t *ring = &chart->state.points;
+
+    g_assert_nonnull(chart);
+    g_return_if_fail(step > 0);
+
+    if (ring->storage != GTK_CHART_STORAGE_UNIFORM_INT16)
+    {
+        ring->y_offset = offset;
+        ring->y_step = step;
+        return;
+    }
+
+    // Requantize stored points
+    chart_ring_convert(ring, ring->storage, offset, step);
+    chart->state.point_list_stale = TRUE;
+    chart->state.data_serial++;
+
+    chart_queue_redraw(chart);
+}
+
+EXPORT unsigned int gtk_chart_add_series(GtkChart *chart, const char *color)
+{
+    static const char *palette[] =
+    {
+        "#e6194b", "#3cb44b", "#4363d8", "#f58231", "#911eb4", "#42d4f4", "#f032e6", "#9a6324"
+    };
+
+    g_assert_nonnull(chart);
+
+    // Samples of new series start with the next plotted point
+    unsigned int index = chart_ring_add_series(&chart->state.points);
+    struct chart_series_t *series = g_new0(struct chart_series_t, 1);
+
+    if (color == NULL || !gdk_rgba_parse(&series->color, color))
+    {
+        gdk_rgba_parse(&series->color, palette[(index - 1) % G_N_ELEMENTS(palette)]);
+    }
+
+    chart->state.series_list = g_slist_append(chart->state.series_list, series);
+    chart->state.series_serial++;
+
+    // Mark widget dirty, redrawn on next frame clock tick
+    chart_queue_redraw(chart);
+
+    return index;
+}
+
+EXPORT unsigned int gtk_chart_get_n_series(GtkChart *chart)
+{
+    return chart->state.points.n_series;
+}
+
+EXPORT void gtk_chart_plot_series_point(GtkChart *chart, double x, const double *ys)
+{
+    g_assert_nonnull(chart);
+    g_assert_nonnull(ys);
+
+    // Add point with one y per series to ring buffer
+    chart_ring_push(&chart->state.points, x, ys, chart->state.points.n_series);
+    chart->state.point_list_stale = TRUE;
+
+    // Mark widget dirty, redrawn on next frame clock tick
+    chart_queue_redraw(chart);
+}
+
+EXPORT void gtk_chart_plot_series_points(GtkChart *chart, const double *xs, const double * const *ys, size_t n)
+{
+    g_assert_nonnull(chart);
+
+    if (n == 0)
+    {
+        return;
+    }
+
+    g_assert_nonnull(xs);
+    g_assert_nonnull(ys);
+
+    // Copy shared x and every series' y into ring buffer
+    chart_ring_push_block(&chart->state.points, xs, ys, chart->state.points.n_series, n);
+    chart->state.point_list_stale = TRUE;
+
+    // Mark widget dirty, redrawn on next frame clock tick
+    chart_queue_redraw(chart);
+}
+
+// Move queued points of writer into ring buffer, runs on the main thread every frame while points arrive
+static gboolean chart_writer_tick_callback(GtkWidget *widget, GdkFrameClock *frame_clock, gpointer user_data)
+{
+    UNUSED(frame_clock);
+
+    GtkChart *self = GTK_CHART(widget);
+    GtkChartWriter *writer = user_data;
+    size_t head = atomic_load_explicit(&writer->head, memory_order_acquire);
+    size_t tail = atomic_load_explicit(&writer->tail, memory_order_relaxed);
+
+    if (head != tail)
+    {
+        unsigned int n_ys = MIN(writer->n_values - 1, self->state.points.n_series);
+
+        for (; tail != head; tail++)
+        {
+            const double *slot = &writer->slots[(tail & (writer->capacity - 1)) * writer->n_values];
+
+            chart_ring_push(&self->state.points, slot[0], &slot[1], n_ys);
+        }
+
+        // Hand slots back to producer
+        atomic_store_explicit(&writer->tail, tail, memory_order_release);
+
+        self->state.point_list_stale = TRUE;
+        chart_queue_redraw(self);
+    }
+
+    // Disarm, then look again for a point the producer queued while still seeing the tick armed
+    atomic_store_explicit(&writer->armed, false, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&writer->head, memory_order_relaxed) != tail)
+    {
+        atomic_store_explicit(&writer->armed, true, memory_order_relaxed);
+        return G_SOURCE_CONTINUE;
+    }
+
+    return G_SOURCE_REMOVE;
+}
+
+static void chart_writer_tick_destroy(gpointer data)
+{
+    GtkChartWriter *writer = data;
+
+    writer->tick_id = 0;
+}
+
+static void chart_writer_unref(gpointer data)
+{
+    GtkChartWriter *writer = data;
+
+    if (g_atomic_ref_count_dec(&writer->ref_count))
+    {
+        g_object_unref(writer->chart);
+        g_free(writer->slots);
+        g_aligned_free(writer);
+    }
+}
+
+// Start drain tick on the main thread, requested by the producer when the queue stops being empty
+static gboolean chart_writer_arm(gpointer data)
+{
+    GtkChartWriter *writer = data;
+
+    if (!writer->closed && writer->tick_id == 0)
+    {
+        writer->tick_id = gtk_widget_add_tick_callback(GTK_WIDGET(writer->chart), chart_writer_tick_callback,
+                                                       writer, chart_writer_tick_destroy);
+    }
+
+    return G_SOURCE_REMOVE;
+}
+
+EXPORT GtkChartWriter * gtk_chart_writer_new(GtkChart *chart, size_t capacity)
+{
+    GtkChartWriter *writer;
+
+    g_assert_nonnull(chart);
+    g_return_val_if_fail(capacity > 0, NULL);
+
+    writer = g_aligned_alloc0(1, sizeof(GtkChartWriter), G_ALIGNOF(GtkChartWriter));
+    writer->chart = g_object_ref(chart);
+    writer->n_values = 1 + chart->state.points.n_series;
+    writer->capacity = 1;
+    while (writer->capacity < capacity)
+    {
+        writer->capacity *= 2;
+    }
+    writer->slots = g_new(double, writer->capacity * writer->n_values);
+    atomic_init(&writer->head, 0);
+    atomic_init(&writer->tail, 0);
+    atomic_init(&writer->dropped, 0);
+    atomic_init(&writer->armed, false);
+    g_atomic_ref_count_init(&writer->ref_count);
+
+    return writer;
+}
+
+// Call on the main thread once the producer has stopped, queued points are discarded
+EXPORT void gtk_chart_writer_free(GtkChartWriter *writer)
+{
+    if (writer == NULL)
+    {
+        return;
+    }
+
+    // Re-arm requests still queued on the main context hold a reference and find the writer closed
+    writer->closed = TRUE;
+    if (writer->tick_id != 0)
+    {
+        gtk_widget_remove_tick_callback(GTK_WIDGET(writer->chart), writer->tick_id);
+    }
+
+    chart_writer_unref(writer);
+}
+
+// Queue point with one y per series of the chart when the writer was created. Wait-free except
+// for the push that finds the drain tick stopped, which schedules it on the main loop.
+// Returns false and counts the point as dropped if the queue is full.
+EXPORT bool gtk_chart_writer_push_series(GtkChartWriter *writer, double x, const double *ys)
+{
+    size_t head = atomic_load_explicit(&writer->head, memory_order_relaxed);
+
+    if (head - writer->tail_cache == writer->capacity)
+    {
+        writer->tail_cache = atomic_load_explicit(&writer->tail, memory_order_acquire);
+        if (head - writer->tail_cache == writer->capacity)
+        {
+            atomic_fetch_add_explicit(&writer->dropped, 1, memory_order_relaxed);
+            return false;
+        }
+    }
+
+    double *slot = &writer->slots[(head & (writer->capacity - 1)) * writer->n_values];
+
+    slot[0] = x;
+    memcpy(&slot[1], ys, (writer->n_values - 1) * sizeof(double));
+
+    // Publish point to consumer
+    atomic_store_explicit(&writer->head, head + 1, memory_order_release);
+
+    // Wake drain tick once per transition from idle, the fence pairs with the one in the tick callback
+    atomic_thread_fence(memory_order_seq_cst);
+    if (!atomic_load_explicit(&writer->armed, memory_order_relaxed) &&
+        !atomic_exchange_explicit(&writer->armed, true, memory_order_relaxed))
+    {
+        // Always dispatched by the main loop, never on the producer thread
+        GSource *source = g_idle_source_new();
+
+        g_atomic_ref_count_inc(&writer->ref_count);
+        g_source_set_priority(source, G_PRIORITY_DEFAULT);
+        g_source_set_callback(source, chart_writer_arm, writer, chart_writer_unref);
+        g_source_attach(source, NULL);
+        g_source_unref(source);
+    }
+
+    return true;
+}
+
+EXPORT bool gtk_chart_writer_push(GtkChartWriter *writer, double x, double y)
+{
+    if (writer->n_values == 2)
+    {
+        return gtk_chart_writer_push_series(writer, x, &y);
+    }
+
+    // Other series get no sample
+    double *ys = g_newa(double, writer->n_values - 1);
+
+    ys[0] = y;
+    for (unsigned int s = 1; s < writer->n_values - 1; s++)
+    {
+        ys[s] = NAN;
+    }
+
+    return gtk_chart_writer_push_series(writer, x, ys);
+}
+
+// Points waiting to be drained, safe to call from any thread
+EXPORT size_t gtk_chart_writer_get_queued(GtkChartWriter *writer)
+{
+    size_t tail = atomic_load_explicit(&writer->tail, memory_order_acquire);
+    size_t head = atomic_load_explicit(&writer->head, memory_order_acquire);
+
+    return head - tail;
+}
+
+// Points rejected because the queue was full, safe to call from any thread
+EXPORT guint64 gtk_chart_writer_get_dropped(GtkChartWriter *writer)
+{
+    return atomic_load_explicit(&writer->dropped, memory_order_relaxed);
+}
+
+EXPORT void gtk_chart_add_slice(GtkChart *chart, double value, const char *color, const char *label)
+{
+    // Allocate memory for new slice
+    struct chart_slice_t *slice = g_new0(struct chart_slice_t, 1);
+    slice->value = value;
+    gdk_rgba_parse(&slice->color, color);
+    if(label != NULL) slice->label = g_strdup(label);
+
+    // Add slice to list to be drawn
+    chart->state.slice_list = g_slist_append(chart->state.slice_list, slice);
+
+    // Mark widget dirty, redrawn on next frame clock tick
+    chart_queue_redraw(chart);
+}
+
+EXPORT void gtk_chart_add_column(GtkChart *chart, double value, const char *color, const char *label)
+{
+    // Allocate memory for new column
+    struct chart_column_t *column = g_new0(struct chart_column_t, 1);
+    column->value = value;
+    gdk_rgba_parse(&column->color, color);
+    if(label != NULL)  column->label = g_strdup(label);
+
+    // Add column to list to be drawn
+    chart->state.column_list = g_slist_append(chart->state.column_list, column);
+
+    // Mark widget dirty, redrawn on next frame clock tick
+    chart_queue_redraw(chart);
+}
+
+EXPORT void gtk_chart_set_value(GtkChart *chart, double value)
+{
+    chart->state.value = value;
+
+    // Mark widget dirty, redrawn on next frame clock tick
+    chart_queue_redraw(chart);
+}
+
+// LTTB picks from the points in the ring buffer, a budget below 3 is taken as 3. Points in history
+// or a series file are drawn from block summaries, at most first/min/max/last per bucket, in either mode.
+EXPORT void gtk_chart_set_downsample(GtkChart *chart, GtkChartDownsample mode, unsigned int budget)
+{
+    g_assert_nonnull(chart);
+
+    chart->state.downsample = mode;
+    chart->state.downsample_budget = budget;
+
+    chart_queue_redraw(chart);
+}
+
+EXPORT GtkChartDownsample gtk_chart_get_downsample(GtkChart *chart)
+{
+    return chart->state.downsample;
+}
+
+EXPORT void gtk_chart_set_max_fps(GtkChart *chart, double fps)
+{
+    g_assert_nonnull(chart);
+
+    chart->max_fps = MAX(fps, 0);
+}
+
+EXPORT double gtk_chart_get_max_fps(GtkChart *chart)
+{
+    return chart->max_fps;
+}
+
+EXPORT void gtk_chart_set_strip_chart(GtkChart *chart, bool enable)
+{
+    g_assert_nonnull(chart);
+
+    chart->state.strip.enabled = enable;
+    if (!enable)
+    {
+        g_clear_pointer(&chart->state.strip.surface, cairo_surface_destroy);
+    }
+
+    chart_queue_redraw(chart);
+}
+
+EXPORT bool gtk_chart_get_strip_chart(GtkChart *chart)
+{
+    return chart->state.strip.enabled;
+}
+
+EXPORT void gtk_chart_set_tiled_rendering(GtkChart *chart, bool enable)
+{
+    g_assert_nonnull(chart);
+
+    chart->state.tiled = enable;
+    chart_queue_redraw(chart);
+}
+
+EXPORT bool gtk_chart_get_tiled_rendering(GtkChart *chart)
+{
+    g_assert_nonnull(chart);
+
+    return chart->state.tiled;
+}
+
+EXPORT void gtk_chart_set_density(GtkChart *chart, unsigned int cell_size)
+{
+    g_assert_nonnull(chart);
+
+    chart->state.density = cell_size;
+    chart_queue_redraw(chart);
+}
+
+EXPORT unsigned int gtk_chart_get_density(GtkChart *chart)
+{
+    g_assert_nonnull(chart);
+
+    return chart->state.density;
+}
+
+EXPORT void gtk_chart_set_marker(GtkChart *chart, GtkChartMarker shape, double size)
+{
+    g_assert_nonnull(chart);
+
+    chart->state.marker.shape = shape;
+    chart->state.marker.size = MAX(size, 1.0);
+
+    // Render new sprite on next draw
+    g_clear_pointer(&chart->state.marker.surface, cairo_surface_destroy);
+    g_clear_object(&chart->state.marker.texture);
+
+    chart_queue_redraw(chart);
+}
+
+EXPORT GtkChartMarker gtk_chart_get_marker(GtkChart *chart)
+{
+    return chart->state.marker.shape;
+}
+
+EXPORT double gtk_chart_get_marker_size(GtkChart *chart)
+{
+    return chart->state.marker.size;
+}
+
+EXPORT void gtk_chart_set_value_min(GtkChart *chart, double value)
+{
+    chart->state.value_min = value;
+}
+
+EXPORT void gtk_chart_set_value_max(GtkChart *chart, double value)
+{
+    chart->state.value_max = value;
+}
+
+EXPORT double gtk_chart_get_value_min(GtkChart *chart)
+{
+    return chart->state.value_min;
+}
+
+EXPORT double gtk_chart_get_value_max(GtkChart *chart)
+{
+    return chart->state.value_max;
+}
+
+EXPORT double gtk_chart_get_x_max(GtkChart *chart)
+{
+    return chart->state.x_max;
+}
+
+EXPORT double gtk_chart_get_x_min(GtkChart *chart)
+{
+    return chart->state.x_min;
+}
+
+EXPORT double gtk_chart_get_y_max(GtkChart *chart)
+{
+    return chart->state.y_max;
+}
+
+EXPORT double gtk_chart_get_y_min(GtkChart *chart)
+{
+    return chart->state.y_min;
+}
+
+#define CHART_CSV_BUFFER_SIZE 65536
+#define CHART_CSV_FIELD_MAX 352             // Sign, 309 integer digits, point and 17 decimals of %f
+#define CHART_CSV_PRECISION_MAX 17
+#define CHART_CSV_CANCEL_ROWS 4096          // Rows between cancellation checks
+#define CHART_CSV_PROGRESS_ROWS 262144      // Rows between progress reports
+#define CHART_CSV_CHUNK_SIZE (4 << 20)      // Bytes parsed per pool job
+
+// Decimal that reads back as the same double, Grisu2 (Loitsch, "Printing Floating-Point
+// Numbers Quickly and Accurately with Integers"). Digits are scaled by a cached power of ten
+// so all arithmetic fits in 64-bit integers. Grisu2 always round-trips but, without the
+// Grisu3 shortness check, about 0.1% of values get one digit more than needed
+// (1e23 -> 9.999999999999999e22).
+struct chart_diy_fp_t
+{
+    guint64 f;
+    int e;
+};
+
+static const struct chart_diy_fp_t chart_cached_powers[] =
+{
+        { G_GUINT64_CONSTANT(0xfa8fd5a0081c0288), -1220 }, { G_GUINT64_CONSTANT(0xbaaee17fa23ebf76), -1193 }, { G_GUINT64_CONSTANT(0x8b16fb203055ac76), -1166 },
+        { G_GUINT64_CONSTANT(0xcf42894a5dce35ea), -1140 }, { G_GUINT64_CONSTANT(0x9a6bb0aa55653b2d), -1113 }, { G_GUINT64_CONSTANT(0xe61acf033d1a45df), -1087 },
+        { G_GUINT64_CONSTANT(0xab70fe17c79ac6ca), -1060 }, { G_GUINT64_CONSTANT(0xff77b1fcbebcdc4f), -1034 }, { G_GUINT64_CONSTANT(0xbe5691ef416bd60c), -1007 },
+        { G_GUINT64_CONSTANT(0x8dd01fad907ffc3c),  -980 }, { G_GUINT64_CONSTANT(0xd3515c2831559a83),  -954 }, { G_GUINT64_CONSTANT(0x9d71ac8fada6c9b5),  -927 },
+        { G_GUINT64_CONSTANT(0xea9c227723ee8bcb),  -901 }, { G_GUINT64_CONSTANT(0xaecc49914078536d),  -874 }, { G_GUINT64_CONSTANT(0x823c12795db6ce57),  -847 },
+        { G_GUINT64_CONSTANT(0xc21094364dfb5637),  -821 }, { G_GUINT64_CONSTANT(0x9096ea6f3848984f),  -794 }, { G_GUINT64_CONSTANT(0xd77485cb25823ac7),  -768 },
+        { G_GUINT64_CONSTANT(0xa086cfcd97bf97f4),  -741 }, { G_GUINT64_CONSTANT(0xef340a98172aace5),  -715 }, { G_GUINT64_CONSTANT(0xb23867fb2a35b28e),  -688 },
+        { G_GUINT64_CONSTANT(0x84c8d4dfd2c63f3b),  -661 }, { G_GUINT64_CONSTANT(0xc5dd44271ad3cdba),  -635 }, { G_GUINT64_CONSTANT(0x936b9fcebb25c996),  -608 },
+        { G_GUINT64_CONSTANT(0xdbac6c247d62a584),  -582 }, { G_GUINT64_CONSTANT(0xa3ab66580d5fdaf6),  -555 }, { G_GUINT64_CONSTANT(0xf3e2f893dec3f126),  -529 },
+        { G_GUINT64_CONSTANT(0xb5b5ada8aaff80b8),  -502 }, { G_GUINT64_CONSTANT(0x87625f056c7c4a8b),  -475 }, { G_GUINT64_CONSTANT(0xc9bcff6034c13053),  -449 },
+        { G_GUINT64_CONSTANT(0x964e858c91ba2655),  -422 }, { G_GUINT64_CONSTANT(0xdff9772470297ebd),  -396 }, { G_GUINT64_CONSTANT(0xa6dfbd9fb8e5b88f),  -369 },
+        { G_GUINT64_CONSTANT(0xf8a95fcf88747d94),  -343 }, { G_GUINT64_CONSTANT(0xb94470938fa89bcf),  -316 }, { G_GUINT64_CONSTANT(0x8a08f0f8bf0f156b),  -289 },
+        { G_GUINT64_CONSTANT(0xcdb02555653131b6),  -263 }, { G_GUINT64_CONSTANT(0x993fe2c6d07b7fac),  -236 }, { G_GUINT64_CONSTANT(0xe45c10c42a2b3b06),  -210 },
+        { G_GUINT64_CONSTANT(0xaa242499697392d3),  -183 }, { G_GUINT64_CONSTANT(0xfd87b5f28300ca0e),  -157 }, { G_GUINT64_CONSTANT(0xbce5086492111aeb),  -130 },
+        { G_GUINT64_CONSTANT(0x8cbccc096f5088cc),  -103 }, { G_GUINT64_CONSTANT(0xd1b71758e219652c),   -77 }, { G_GUINT64_CONSTANT(0x9c40000000000000),   -50 },
+        { G_GUINT64_CONSTANT(0xe8d4a51000000000),   -24 }, { G_GUINT64_CONSTANT(0xad78ebc5ac620000),     3 }, { G_GUINT64_CONSTANT(0x813f3978f8940984),    30 },
+        { G_GUINT64_CONSTANT(0xc097ce7bc90715b3),    56 }, { G_GUINT64_CONSTANT(0x8f7e32ce7bea5c70),    83 }, { G_GUINT64_CONSTANT(0xd5d238a4abe98068),   109 },
+        { G_GUINT64_CONSTANT(0x9f4f2726179a2245),   136 }, { G_GUINT64_CONSTANT(0xed63a231d4c4fb27),   162 }, { G_GUINT64_CONSTANT(0xb0de65388cc8ada8),   189 },
+        { G_GUINT64_CONSTANT(0x83c7088e1aab65db),   216 }, { G_GUINT64_CONSTANT(0xc45d1df942711d9a),   242 }, { G_GUINT64_CONSTANT(0x924d692ca61be758),   269 },
+        { G_GUINT64_CONSTANT(0xda01ee641a708dea),   295 }, { G_GUINT64_CONSTANT(0xa26da3999aef774a),   322 }, { G_GUINT64_CONSTANT(0xf209787bb47d6b85),   348 },
+        { G_GUINT64_CONSTANT(0xb454e4a179dd1877),   375 }, { G_GUINT64_CONSTANT(0x865b86925b9bc5c2),   402 }, { G_GUINT64_CONSTANT(0xc83553c5c8965d3d),   428 },
+        { G_GUINT64_CONSTANT(0x952ab45cfa97a0b3),   455 }, { G_GUINT64_CONSTANT(0xde469fbd99a05fe3),   481 }, { G_GUINT64_CONSTANT(0xa59bc234db398c25),   508 },
+        { G_GUINT64_CONSTANT(0xf6c69a72a3989f5c),   534 }, { G_GUINT64_CONSTANT(0xb7dcbf5354e9bece),   561 }, { G_GUINT64_CONSTANT(0x88fcf317f22241e2),   588 },
+        { G_GUINT64_CONSTANT(0xcc20ce9bd35c78a5),   614 }, { G_GUINT64_CONSTANT(0x98165af37b2153df),   641 }, { G_GUINT64_CONSTANT(0xe2a0b5dc971f303a),   667 },
+        { G_GUINT64_CONSTANT(0xa8d9d1535ce3b396),   694 }, { G_GUINT64_CONSTANT(0xfb9b7cd9a4a7443c),   720 }, { G_GUINT64_CONSTANT(0xbb764c4ca7a44410),   747 },
+        { G_GUINT64_CONSTANT(0x8bab8eefb6409c1a),   774 }, { G_GUINT64_CONSTANT(0xd01fef10a657842c),   800 }, { G_GUINT64_CONSTANT(0x9b10a4e5e9913129),   827 },
+        { G_GUINT64_CONSTANT(0xe7109bfba19c0c9d),   853 }, { G_GUINT64_CONSTANT(0xac2820d9623bf429),   880 }, { G_GUINT64_CONSTANT(0x80444b5e7aa7cf85),   907 },
+        { G_GUINT64_CONSTANT(0xbf21e44003acdd2d),   933 }, { G_GUINT64_CONSTANT(0x8e679c2f5e44ff8f),   960 }, { G_GUINT64_CONSTANT(0xd433179d9c8cb841),   986 },
+        { G_GUINT64_CONSTANT(0x9e19db92b4e31ba9),  1013 }, { G_GUINT64_CONSTANT(0xeb96bf6ebadf77d9),  1039 }, { G_GUINT64_CONSTANT(0xaf87023b9bf0ee6b),  1066 },
+};
+
+static struct chart_diy_fp_t chart_diy_fp_multiply(struct chart_diy_fp_t x, struct chart_diy_fp_t y)
+{
+    const guint64 mask = 0xffffffffu;
+    guint64 a = x.f >> 32, b = x.f & mask, c = y.f >> 32, d = y.f & mask;
+    guint64 ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+    guint64 middle = (bd >> 32) + (ad & mask) + (bc & mask) + (1u << 31);   // Rounded
+    struct chart_diy_fp_t product = { ac + (ad >> 32) + (bc >> 32) + (middle >> 32), x.e + y.e + 64 };
+
+    return product;
+}
+
+static struct chart_diy_fp_t chart_diy_fp_normalize(struct chart_diy_fp_t x)
+{
+    while (!(x.f & G_GUINT64_CONSTANT(0x8000000000000000)))
+    {
+        x.f <<= 1;
+        x.e--;
+    }
+
+    return x;
+}
+
+static void chart_grisu_round(char *digits, int length, guint64 delta, guint64 rest, guint64 ten_kappa, guint64 wp_w)
+{
+    // Move last digit towards the exact value while staying inside the rounding interval
+    while (rest < wp_w && delta - rest >= ten_kappa &&
+           (rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w))
+    {
+        digits[length - 1]--;
+        rest += ten_kappa;
+    }
+}
+
+// Digits of positive finite value, which equals digits * 10^exponent
+static int chart_grisu2(double value, char *digits, int *exponent)
+{
+    static const guint64 pow10[] =
+    {
+        1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000,
+        G_GUINT64_CONSTANT(10000000000), G_GUINT64_CONSTANT(100000000000), G_GUINT64_CONSTANT(1000000000000),
+        G_GUINT64_CONSTANT(10000000000000), G_GUINT64_CONSTANT(100000000000000),
+        G_GUINT64_CONSTANT(1000000000000000), G_GUINT64_CONSTANT(10000000000000000),
+        G_GUINT64_CONSTANT(100000000000000000), G_GUINT64_CONSTANT(1000000000000000000),
+        G_GUINT64_CONSTANT(10000000000000000000)
+    };
+    const guint64 hidden = G_GUINT64_CONSTANT(1) << 52;
+    guint64 bits = chart_double_bits(value);
+    int biased = (int) ((bits >> 52) & 0x7ff);
+    struct chart_diy_fp_t v = { bits & (hidden - 1), -1074 };
+
+    if (biased != 0)
+    {
+        v.f += hidden;
+        v.e = biased - 1075;
+    }
+
+    // Boundaries halfway to the neighbouring doubles, the lower one is closer at powers of two
+    struct chart_diy_fp_t plus = { (v.f << 1) + 1, v.e - 1 };
+    while (!(plus.f & (hidden << 1)))
+    {
+        plus.f <<= 1;
+        plus.e--;
+    }
+    plus.f <<= 10;
+    plus.e -= 10;
+
+    struct chart_diy_fp_t minus = (v.f == hidden) ? (struct chart_diy_fp_t) { (v.f << 2) - 1, v.e - 2 } :
+                                                     (struct chart_diy_fp_t) { (v.f << 1) - 1, v.e - 1 };
+    minus.f <<= minus.e - plus.e;
+    minus.e = plus.e;
+
+    // Cached power bringing the upper boundary's binary exponent into [-60, -32]
+    double dk = (-61 - plus.e) * 0.30102999566398114 + 347;
+    int k = (int) dk;
+    if (dk - k > 0.0)
+    {
+        k++;
+    }
+    unsigned int index = (unsigned int) ((k >> 3) + 1);
+    struct chart_diy_fp_t power = chart_cached_powers[index];
+    int power_exponent = -(-348 + (int) index * 8);
+
+    struct chart_diy_fp_t w = chart_diy_fp_multiply(chart_diy_fp_normalize(v), power);
+    struct chart_diy_fp_t wp = chart_diy_fp_multiply(plus, power);
+    struct chart_diy_fp_t wm = chart_diy_fp_multiply(minus, power);
+    wm.f++;
+    wp.f--;
+
+    // Generate digits of upper boundary until they are inside the interval
+    guint64 delta = wp.f - wm.f;
+    guint64 wp_w = wp.f - w.f;
+    int shift = -wp.e;
+    guint64 one = G_GUINT64_CONSTANT(1) << shift;
+    guint32 p1 = (guint32) (wp.f >> shift);
+    guint64 p2 = wp.f & (one - 1);
+    int kappa = 1;
+    int length = 0;
+
+    while (kappa < 10 && p1 >= pow10[kappa])
+    {
+        kappa++;
+    }
+
+    while (kappa > 0)
+    {
+        guint32 digit = (guint32) (p1 / pow10[kappa - 1]);
+
+        p1 %= (guint32) pow10[kappa - 1];
+        if (digit != 0 || length != 0)
+        {
+            digits[length++] = (char) ('0' + digit);
+        }
+        kappa--;
+
+        guint64 rest = ((guint64) p1 << shift) + p2;
+        if (rest <= delta)
+        {
+            *exponent = power_exponent + kappa;
+            chart_grisu_round(digits, length, delta, rest, pow10[kappa] << shift, wp_w);
+            return length;
+        }
+    }
+
+    for (;;)
+    {
+        p2 *= 10;
+        delta *= 10;
+
+        char digit = (char) (p2 >> shift);
+        if (digit != 0 || length != 0)
+        {
+            digits[length++] = (char) ('0' + digit);
+        }
+        p2 &= one - 1;
+        kappa--;
+
+        if (p2 < delta)
+        {
+            *exponent = power_exponent + kappa;
+            chart_grisu_round(digits, length, delta, p2, one, (-kappa < 20) ? wp_w * pow10[-kappa] : 0);
+            return length;
+        }
+    }
+}
+
+// Write value with at most 17 significant digits that read back exactly, returns end of text
+static char * chart_format_roundtrip(char *out, double value)
+{
+    char digits[24];
+    int exponent;
+
+    if (value == 0)
+    {
+        if (signbit(value))
+        {
+            *out++ = '-';
+        }
+        *out++ = '0';
+        return out;
+    }
+
+    if (value < 0)
+    {
+        *out++ = '-';
+        value = -value;
+    }
+
+    int length = chart_grisu2(value, digits, &exponent);
+    int point = length + exponent;     // Position of decimal point relative to first digit
+
+    if (exponent >= 0 && point <= 21)
+    {
+        // Integer, 1234e2 -> 123400
+        memcpy(out, digits, length);
+        memset(out + length, '0', exponent);
+        return out + point;
+    }
+
+    if (point > 0 && point <= 21)
+    {
+        // 1234e-2 -> 12.34
+        memcpy(out, digits, point);
+        out[point] = '.';
+        memcpy(out + point + 1, digits + point, length - point);
+        return out + length + 1;
+    }
+
+    if (point > -6 && point <= 0)
+    {
+        // 1234e-6 -> 0.001234
+        out[0] = '0';
+        out[1] = '.';
+        memset(out + 2, '0', -point);
+        memcpy(out + 2 - point, digits, length);
+        return out + 2 - point + length;
+    }
+
+    // Scientific, 1234e30 -> 1.234e33
+    *out++ = digits[0];
+    if (length > 1)
+    {
+        *out++ = '.';
+        memcpy(out, digits + 1, length - 1);
+        out += length - 1;
+    }
+    *out++ = 'e';
+    out += sprintf(out, "%d", point - 1);
+
+    return out;
+}
+
+// Write value rounded to precision decimals, returns end of text
+static char * chart_format_fixed(char *out, double value, int precision, const char *format)
+{
+    static const double scales[] =
+    {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17
+    };
+    double product = fabs(value) * scales[precision];
+    char digits[24];
+    int length = 0;
+
+    if (!(product < 4503599627370496.0))
+    {
+        // Too large to round exactly in an integer, let printf do it
+        g_ascii_formatd(out, CHART_CSV_FIELD_MAX, format, value);
+        return out + strlen(out);
+    }
+
+    // Round exact product, the rounding error of the multiplication is recovered with fma()
+    double scaled = floor(product);
+    double fraction = (product - scaled) + fma(fabs(value), scales[precision], -product);
+    if (fraction > 0.5 || (fraction == 0.5 && fmod(scaled, 2) != 0))
+    {
+        scaled += 1;
+    }
+
+    guint64 n = (guint64) scaled;
+    do
+    {
+        digits[length++] = (char) ('0' + n % 10);
+        n /= 10;
+    } while (n != 0 || length <= precision);
+
+    if (value < 0 && scaled != 0)
+    {
+        *out++ = '-';
+    }
+    while (length > precision)
+    {
+        *out++ = digits[--length];
+    }
+    if (precision > 0)
+    {
+        *out++ = '.';
+        while (length > 0)
+        {
+            *out++ = digits[--length];
+        }
+    }
+
+    return out;
+}
+
+struct chart_csv_writer_t
+{
+    GOutputStream *stream;
+    GCancellable *cancellable;
+    char *buffer;               // CHART_CSV_BUFFER_SIZE bytes
+    size_t length;
+    int precision;              // Decimals, -1 for round-trip
+    char format[8];             // printf fallback for fixed precision
+    char delimiter;
+    guint64 rows;
+    guint64 total;
+    void (*progress)(struct chart_csv_writer_t *writer);
+    gpointer progress_data;
+};
+
+static bool chart_csv_flush(struct chart_csv_writer_t *writer, GError **error)
+{
+    bool ok = g_output_stream_write_all(writer->stream, writer->buffer, writer->length,
+                                        NULL, writer->cancellable, error);
+
+    writer->length = 0;
+    return ok;
+}
+
+// Append row of x followed by y of each series, missing samples left empty
+static bool chart_csv_write_row(struct chart_csv_writer_t *writer, double x, const double *ys, size_t stride,
+                                unsigned int n_series, GError **error)
+{
+    for (unsigned int s = 0; s <= n_series; s++)
+    {
+        double value = (s == 0) ? x : ys[(s - 1) * stride];
+        char *out;
+
+        if (CHART_CSV_BUFFER_SIZE - writer->length < CHART_CSV_FIELD_MAX + 2 && !chart_csv_flush(writer, error))
+        {
+            return false;
+        }
+
+        out = writer->buffer + writer->length;
+        if (s > 0)
+        {
+            *out++ = writer->delimiter;
+        }
+
+        if (isnan(value))
+        {
+            // Empty field
+        }
+        else if (isinf(value))
+        {
+            out = g_stpcpy(out, (value < 0) ? "-inf" : "inf");
+        }
+        else if (writer->precision < 0)
+        {
+            out = chart_format_roundtrip(out, value);
+        }
+        else
+        {
+            out = chart_format_fixed(out, value, writer->precision, writer->format);
+        }
+
+        writer->length = out - writer->buffer;
+    }
+    writer->buffer[writer->length++] = '\n';
+
+    writer->rows++;
+    if (writer->rows % CHART_CSV_CANCEL_ROWS == 0)
+    {
+        if (g_cancellable_set_error_if_cancelled(writer->cancellable, error))
+        {
+            return false;
+        }
+        if (writer->progress != NULL && writer->rows % CHART_CSV_PROGRESS_ROWS == 0)
+        {
+            writer->progress(writer);
+        }
+    }
+
+    return true;
+}
+
+// Write one row per point, mapped file and points kept in history first
+static bool chart_csv_write(const struct chart_state_t *state, struct chart_csv_writer_t *writer, GError **error)
+{
+    const struct chart_ring_t *ring = &state->points;
+    const struct chart_history_t *history = &ring->history;
+    g_autofree double *columns = g_new(double, (ring->n_series + 1) * CHART_HISTORY_BLOCK);
+    g_autofree char *buffer = g_malloc(CHART_CSV_BUFFER_SIZE);
+
+    writer->buffer = buffer;
+    writer->length = 0;
+    writer->rows = 0;
+    writer->total = state->mapped.count + chart_history_n_points(history) + ring->count;
+    if (writer->precision >= 0)
+    {
+        g_snprintf(writer->format, sizeof(writer->format), "%%.%df", writer->precision);
+    }
+
+    for (size_t i = 0; i < state->mapped.count; i++)
+    {
+        for (unsigned int s = 0; s < ring->n_series; s++)
+        {
+            columns[s] = (s < state->mapped.n_series) ? chart_mapped_value(&state->mapped, i, s + 1) : NAN;
+        }
+        if (!chart_csv_write_row(writer, chart_mapped_value(&state->mapped, i, 0), columns, 1, ring->n_series, error))
+        {
+            return false;
+        }
+    }
+
+    for (size_t b = 0; b < chart_history_n_blocks(history); b++)
+    {
+        const struct chart_history_block_t *block = chart_history_block(history, b);
+
+        chart_history_read(history, block, 0, columns, NULL);
+        for (unsigned int s = 0; s < ring->n_series; s++)
+        {
+            chart_history_read(history, block, s, NULL, &columns[(s + 1) * CHART_HISTORY_BLOCK]);
+        }
+
+        for (size_t i = 0; i < block->count; i++)
+        {
+            if (!chart_csv_write_row(writer, columns[i], &columns[CHART_HISTORY_BLOCK + i],
+                                     CHART_HISTORY_BLOCK, ring->n_series, error))
+            {
+                return false;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < ring->count; i++)
+    {
+        size_t slot = chart_ring_slot(ring, i);
+
+        for (unsigned int s = 0; s < ring->n_series; s++)
+        {
+            columns[s] = chart_ring_y(ring, s, slot);
+        }
+        if (!chart_csv_write_row(writer, chart_ring_x(ring, slot), columns, 1, ring->n_series, error))
+        {
+            return false;
+        }
+    }
+
+    if (!chart_csv_flush(writer, error))
+    {
+        return false;
+    }
+    if (writer->progress != NULL)
+    {
+        writer->progress(writer);
+    }
+
+    return true;
+}
+
+EXPORT void gtk_chart_set_csv_format(GtkChart *chart, int precision, char delimiter)
+{
+    g_assert_nonnull(chart);
+    g_return_if_fail(precision <= CHART_CSV_PRECISION_MAX);
+    g_return_if_fail(delimiter != '\n' && delimiter != '\0');
+
+    chart->state.csv_precision = MAX(precision, -1);
+    chart->state.csv_delimiter = delimiter;
+}
+
+EXPORT bool gtk_chart_write_csv(GtkChart *chart, GOutputStream *stream, GCancellable *cancellable, GError **error)
+{
+    g_assert_nonnull(chart);
+    g_return_val_if_fail(G_IS_OUTPUT_STREAM(stream), false);
+
+    struct chart_csv_writer_t writer =
+    {
+        .stream = stream,
+        .cancellable = cancellable,
+        .precision = chart->state.csv_precision,
+        .delimiter = chart->state.csv_delimiter,
+    };
+
+    return chart_csv_write(&chart->state, &writer, error);
+}
+
+// Close stream of g_file_replace() without replacing the original file
+static void chart_output_stream_abort(GOutputStream *stream)
+{
+    g_autoptr (GCancellable) abort = g_cancellable_new();
+
+    g_cancellable_cancel(abort);
+    g_output_stream_close(stream, abort, NULL);
+}
+
+EXPORT bool gtk_chart_save_csv(GtkChart *chart, const char *filename, GError **error)
+{
+    g_assert_nonnull(chart);
+    g_assert_nonnull(filename);
+
+    g_autoptr (GFile) file = g_file_new_for_path(filename);
+    g_autoptr (GFileOutputStream) stream;
+
+    // Written to a temporary file, which replaces filename on successful close
+    stream = g_file_replace(file, NULL, FALSE, G_FILE_CREATE_NONE, NULL, error);
+    if (stream == NULL)
+    {
+        return false;
+    }
+
+    if (!gtk_chart_write_csv(chart, G_OUTPUT_STREAM(stream), NULL, error))
+    {
+        chart_output_stream_abort(G_OUTPUT_STREAM(stream));
+        return false;
+    }
+
+    return g_output_stream_close(G_OUTPUT_STREAM(stream), NULL, error);
+}
+
+static inline guint64 chart_binary_double(double value)
+{
+    return GUINT64_TO_LE(chart_double_bits(value));
+}
+
+static inline double chart_binary_read_double(guint64 bits)
+{
+    return chart_bits_double(GUINT64_FROM_LE(bits));
+}
+
+static inline size_t chart_binary_align(size_t offset)
+{
+    return (offset + CHART_BINARY_ALIGN - 1) & ~(size_t) (CHART_BINARY_ALIGN - 1);
+}
+
+// Write n samples of element size in little-endian order, big-endian hosts swap through buffer
+static bool chart_binary_write(GOutputStream *stream, const void *data, size_t element, size_t n,
+                               guint8 *buffer, GError **error)
+{
+#if G_BYTE_ORDER == G_BIG_ENDIAN
+    size_t chunk = CHART_HISTORY_BLOCK * sizeof(double) / element;
+
+    for (size_t i = 0; i < n; i += chunk)
+    {
+        size_t m = MIN(chunk, n - i);
+
+        memcpy(buffer, (const guint8 *) data + i * element, m * element);
+        chart_storage_swap_le(buffer, element, m);
+        if (!g_output_stream_write_all(stream, buffer, m * element, NULL, NULL, error))
+        {
+            return false;
+        }
+    }
+
+    return true;
+#else
+    UNUSED(buffer);
+
+    return g_output_stream_write_all(stream, data, n * element, NULL, NULL, error);
+#endif
+}
+
+// Write x (column 0) or y of series column - 1 of every point in history and ring, in storage format
+static bool chart_binary_write_column(GOutputStream *stream, const struct chart_ring_t *ring, unsigned int column,
+                                      GError **error)
+{
+    const struct chart_history_t *history = &ring->history;
+    size_t element = (column == 0) ? chart_storage_x_size(ring->storage) : chart_storage_y_size(ring->storage);
+    g_autofree double *values = g_new(double, CHART_HISTORY_BLOCK);
+    g_autofree guint8 *encoded = g_malloc(CHART_HISTORY_BLOCK * sizeof(double));
+    g_autofree guint8 *buffer = g_malloc(CHART_HISTORY_BLOCK * sizeof(double));
 
-    // Move coordinate system to bottom left
-    cairo_translate(cr, 0, h);
+    // Single series ring around encoded, history points are stored exactly as the ring would
+    struct chart_ring_series_t scratch_series = { .y = encoded };
+    struct chart_ring_t scratch = *ring;
 
-    // Invert y-axis
-    cairo_scale(cr, 1, -1);
+    scratch.x = encoded;
+    scratch.series = &scratch_series;
 
-    // Draw title
-    double title_font_size = 0.05 * h;  // 5% of total height
-    cairo_set_font_size (cr, title_font_size);
-    cairo_text_extents(cr, self->title, &extents);
-    cairo_move_to (cr, 0.5 * w - extents.width/2, 0.9 * h - extents.height/2);
-    cairo_save(cr);
-    cairo_scale(cr, 1, -1);
-    cairo_show_text (cr, self->title);
-    cairo_restore(cr);
+    for (size_t b = 0; b < chart_history_n_blocks(history); b++)
+    {
+        const struct chart_history_block_t *block = chart_history_block(history, b);
 
-    // Draw label
-    cairo_set_font_size (cr, 25.0 * (w/650));
-    cairo_text_extents(cr, self->label, &extents);
-    cairo_move_to(cr, 0.5 * w - extents.width/2, 0.2 * h - extents.height/2);
-    cairo_save(cr);
-    cairo_scale(cr, 1, -1);
-    cairo_show_text(cr, self->label);
-    cairo_restore(cr);
+        if (column == 0)
+        {
+            chart_history_read(history, block, 0, values, NULL);
+            for (size_t i = 0; i < block->count; i++)
+            {
+                chart_ring_set_x(&scratch, i, values[i]);
+            }
+        }
+        else
+        {
+            chart_history_read(history, block, column - 1, NULL, values);
+            for (size_t i = 0; i < block->count; i++)
+            {
+                chart_ring_set_y(&scratch, 0, i, values[i]);
+            }
+        }
 
-    // Draw number
-    g_snprintf(value, sizeof(value), "%.1f", self->value);
-    cairo_set_font_size (cr, 140.0 * (w/650));
-    cairo_text_extents(cr, value, &extents);
-    cairo_move_to(cr, 0.5 * w - extents.width/2, 0.5 * h - extents.height/2);
-    cairo_save(cr);
-    cairo_scale(cr, 1, -1);
-    cairo_show_text(cr, value);
-    cairo_restore(cr);
+        if (!chart_binary_write(stream, encoded, element, block->count, buffer, error))
+        {
+            return false;
+        }
+    }
 
-    cairo_destroy (cr);
+    // Ring samples are written as stored, in at most two parts
+    const guint8 *data = (column == 0) ? ring->x : ring->series[column - 1].y;
+    size_t part = MIN(ring->count, ring->size - ring->head);
+
+    return chart_binary_write(stream, data + ring->head * element, element, part, buffer, error) &&
+           chart_binary_write(stream, data, element, ring->count - part, buffer, error);
 }
 
-static void chart_draw_gauge_linear(GtkChart *self,
-                                    GtkSnapshot *snapshot,
-                                    float h,
-                                    float w)
+// Snapshot holds the points in history and the ring buffer, an open series file is not included
+EXPORT bool gtk_chart_save_binary(GtkChart *chart, const char *filename, GError **error)
 {
-    cairo_text_extents_t extents;
-    char value[20];
+    static const guint8 zeros[CHART_BINARY_ALIGN] = { 0 };
 
-    // Assume aspect ratio w:h = 1:2
+    g_assert_nonnull(chart);
+    g_assert_nonnull(filename);
+
+    const struct chart_ring_t *ring = &chart->state.points;
+    size_t count = chart_history_n_points(&ring->history) + ring->count;
+    size_t x_size = chart_storage_x_size(ring->storage);
+    size_t y_size = chart_storage_y_size(ring->storage);
+    struct chart_binary_header_t header = { 0 };
+    g_autofree struct chart_binary_series_t *series = g_new0(struct chart_binary_series_t, MAX(ring->n_series, 1));
+    size_t offset = sizeof(header) + ring->n_series * sizeof(series[0]);
+
+    memcpy(header.magic, CHART_BINARY_MAGIC, sizeof(header.magic));
+    header.version = GUINT32_TO_LE(CHART_BINARY_VERSION);
+    header.n_series = GUINT32_TO_LE(ring->n_series);
+    header.count = GUINT64_TO_LE(count);
+    header.storage = GUINT32_TO_LE(ring->storage);
+    header.x_start = chart_binary_double(chart_ring_uniform_x(ring, chart_ring_oldest_seq(ring)));
+    header.x_step = chart_binary_double(ring->x_step);
+    header.y_offset = chart_binary_double(ring->y_offset);
+    header.y_step = chart_binary_double(ring->y_step);
+    header.x_min = chart_binary_double(chart->state.x_min);
+    header.x_max = chart_binary_double(chart->state.x_max);
+    header.y_min = chart_binary_double(chart->state.y_min);
+    header.y_max = chart_binary_double(chart->state.y_max);
+
+    // Lay out columns, x first
+    if (x_size > 0)
+    {
+        offset = chart_binary_align(offset);
+        header.x_offset = GUINT64_TO_LE(offset);
+        offset += count * x_size;
+    }
 
-    // Set up Cairo region
-    cairo_t * cr = gtk_snapshot_append_cairo (snapshot, &GRAPHENE_RECT_INIT(0, 0, w, h));
-    cairo_set_antialias (cr, CAIRO_ANTIALIAS_FAST);
-    cairo_set_tolerance (cr, 1.5);
-    gdk_cairo_set_source_rgba (cr, &self->text_color);
-    cairo_select_font_face (cr, self->font_name, CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+    for (unsigned int s = 0; s < ring->n_series; s++)
+    {
+        offset = chart_binary_align(offset);
+        series[s].offset = GUINT64_TO_LE(offset);
+        offset += count * y_size;
 
-    // Move coordinate system to bottom left
-    cairo_translate(cr, 0, h);
+        const GdkRGBA *color;
+        chart_series_marker(&chart->state, s, &color);
 
-    // Invert y-axis
-    cairo_scale(cr, 1, -1);
+        const float rgba[4] = { color->red, color->green, color->blue, color->alpha };
+        for (unsigned int c = 0; c < 4; c++)
+        {
+            memcpy(&series[s].color[c], &rgba[c], sizeof(guint32));
+            series[s].color[c] = GUINT32_TO_LE(series[s].color[c]);
+        }
+    }
 
-    // Draw title
-    double title_font_size = 0.05 * h;  // 5% of total height
-    cairo_set_font_size (cr, title_font_size);
-    cairo_text_extents(cr, self->title, &extents);
-    cairo_move_to (cr, 0.5 * w - extents.width/2, 0.95 * h - extents.height/2);
-    cairo_save(cr);
-    cairo_scale(cr, 1, -1);
-    cairo_show_text (cr, self->title);
-    cairo_restore(cr);
+    g_autoptr (GFile) file = g_file_new_for_path(filename);
+    g_autoptr (GFileOutputStream) file_stream;
 
-    // Draw label
-    cairo_set_font_size (cr, 25.0 * (w/650));
-    cairo_text_extents(cr, self->label, &extents);
-    cairo_move_to(cr, 0.5 * w - extents.width/2, 0.05 * h - extents.height/2);
-    cairo_save(cr);
-    cairo_scale(cr, 1, -1);
-    cairo_show_text(cr, self->label);
-    cairo_restore(cr);
+    file_stream = g_file_replace(file, NULL, FALSE, G_FILE_CREATE_NONE, NULL, error);
+    if (file_stream == NULL)
+    {
+        return false;
+    }
 
-    // Draw minimum value
-    g_snprintf(value, sizeof(value), "%.0f", self->value_min);
-    cairo_set_font_size (cr, 25.0 * (w/650));
-    cairo_text_extents(cr, value, &extents);
-    cairo_move_to(cr, 0.7 * w, 0.1 * h - extents.height/2);
-    cairo_save(cr);
-    cairo_scale(cr, 1, -1);
-    cairo_show_text(cr, value);
-    cairo_restore(cr);
+    GOutputStream *stream = G_OUTPUT_STREAM(file_stream);
+    bool ok = g_output_stream_write_all(stream, &header, sizeof(header), NULL, NULL, error) &&
+              g_output_stream_write_all(stream, series, ring->n_series * sizeof(series[0]), NULL, NULL, error);
 
-    // Draw maximum value
-    g_snprintf(value, sizeof(value), "%.0f", self->value_max);
-    cairo_set_font_size (cr, 25.0 * (w/650));
-    cairo_text_extents(cr, value, &extents);
-    cairo_move_to(cr, 0.7 * w, 0.9 * h - extents.height/2);
-    cairo_save(cr);
-    cairo_scale(cr, 1, -1);
-    cairo_show_text(cr, value);
-    cairo_restore(cr);
+    offset = sizeof(header) + ring->n_series * sizeof(series[0]);
+    for (unsigned int column = (x_size > 0) ? 0 : 1; ok && column <= ring->n_series; column++)
+    {
+        size_t padding = chart_binary_align(offset) - offset;
 
-    // Draw minimum line
-    gdk_cairo_set_source_rgba (cr, &self->axis_color);
-    cairo_move_to(cr, 0.375 * w, 0.1 * h);
-    cairo_line_to(cr, 0.625 * w, 0.1 * h);
-    cairo_set_line_width (cr, 1);
-    cairo_stroke (cr);
+        ok = g_output_stream_write_all(stream, zeros, padding, NULL, NULL, error) &&
+             chart_binary_write_column(stream, ring, column, error);
+        offset += padding + count * ((column == 0) ? x_size : y_size);
+    }
 
-    // Draw maximum line
-    cairo_move_to(cr, 0.375 * w, 0.9 * h);
-    cairo_line_to(cr, 0.625 * w, 0.9 * h);
-    cairo_set_line_width (cr, 1);
-    cairo_stroke (cr);
+    if (!ok)
+    {
+        chart_output_stream_abort(stream);
+        return false;
+    }
 
-    // Move coordinate system to (0,0) of gauge line start
-    cairo_translate(cr, 0.5 * w, 0.1 * h);
+    return g_output_stream_close(stream, NULL, error);
+}
 
-    // Draw gauge line
-    gdk_cairo_set_source_rgba (cr, &self->line_color);
-    cairo_move_to(cr, 0, 0);
-    float y_scale = (h - 2 * 0.1 * h) / self->value_max;
-    cairo_set_line_width (cr, 0.2 * w);
-    cairo_line_to(cr, 0, self->value * y_scale);
-    cairo_stroke (cr);
+// Column of count samples at offset, NULL if it does not lie within the file
+static const guint8 * chart_binary_column(const guint8 *data, size_t length, guint64 offset, size_t element, guint64 count)
+{
+    if (offset < sizeof(struct chart_binary_header_t) || offset > length || offset % element != 0 ||
+        count > (length - offset) / element)
+    {
+        return NULL;
+    }
 
-    cairo_destroy (cr);
+    return data + offset;
 }
 
-static void chart_draw_gauge_angular(GtkChart *self,
-                                     GtkSnapshot *snapshot,
-                                     float h,
-                                     float w)
+EXPORT bool gtk_chart_load_binary(GtkChart *chart, const char *filename, GError **error)
 {
-    cairo_text_extents_t extents;
-    char value[20];
+    g_assert_nonnull(chart);
+    g_assert_nonnull(filename);
 
-    // Assume aspect ratio w:h = 1:1
+    struct chart_ring_t *ring = &chart->state.points;
+    struct chart_binary_header_t header;
+    g_autoptr (GMappedFile) file = g_mapped_file_new(filename, FALSE, error);
 
-    // Set up Cairo region
-    cairo_t * cr = gtk_snapshot_append_cairo (snapshot, &GRAPHENE_RECT_INIT(0, 0, w, h));
-    cairo_set_antialias (cr, CAIRO_ANTIALIAS_FAST);
-    //  cairo_set_tolerance (cr, 1.5);
-    gdk_cairo_set_source_rgba (cr, &self->text_color);
-    cairo_select_font_face (cr, self->font_name, CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+    if (file == NULL)
+    {
+        return false;
+    }
 
-    // Move coordinate system to bottom left
-    cairo_translate(cr, 0, h);
+    const guint8 *data = (const guint8 *) g_mapped_file_get_contents(file);
+    size_t length = g_mapped_file_get_length(file);
 
-    // Invert y-axis
-    cairo_scale(cr, 1, -1);
+    if (length < sizeof(header) || memcmp(data, CHART_BINARY_MAGIC, sizeof(header.magic)) != 0)
+    {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "%s: Not a chart snapshot file", filename);
+        return false;
+    }
 
-    // Draw title
-    double title_font_size = 0.05 * h;  // 5% of total height
-    cairo_set_font_size (cr, title_font_size);
-    cairo_text_extents(cr, self->title, &extents);
-    cairo_move_to (cr, 0.5 * w - extents.width/2, 0.9 * h - extents.height/2);
-    cairo_save(cr);
-    cairo_scale(cr, 1, -1);
-    cairo_show_text (cr, self->title);
-    cairo_restore(cr);
+    memcpy(&header, data, sizeof(header));
+    guint32 version = GUINT32_FROM_LE(header.version);
+    guint32 n_series = GUINT32_FROM_LE(header.n_series);
+    guint32 storage = GUINT32_FROM_LE(header.storage);
+    guint64 count = GUINT64_FROM_LE(header.count);
+    double x_step = chart_binary_read_double(header.x_step);
+    double y_step = chart_binary_read_double(header.y_step);
 
-    // Draw label
-    cairo_set_font_size (cr, 25.0 * (w/650));
-    cairo_text_extents(cr, self->label, &extents);
-    cairo_move_to(cr, 0.5 * w - extents.width/2, 0.1 * h - extents.height/2);
-    cairo_save(cr);
-    cairo_scale(cr, 1, -1);
-    cairo_show_text(cr, self->label);
-    cairo_restore(cr);
+    if (version != CHART_BINARY_VERSION || storage > GTK_CHART_STORAGE_UNIFORM_INT16 ||
+        n_series == 0 || n_series > CHART_BINARY_MAX_SERIES || !(x_step > 0) || !(y_step > 0))
+    {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "%s: Unsupported chart snapshot file", filename);
+        return false;
+    }
 
-    // Draw minimum value
-    g_snprintf(value, sizeof(value), "%.0f", self->value_min);
-    cairo_set_font_size (cr, 25.0 * (w/650));
-    cairo_text_extents(cr, value, &extents);
-    cairo_move_to(cr, 0.225 * w, 0.25 * h - extents.height/2);
-    cairo_save(cr);
-    cairo_scale(cr, 1, -1);
-    cairo_show_text(cr, value);
-    cairo_restore(cr);
+    if ((length - sizeof(header)) / sizeof(struct chart_binary_series_t) < n_series)
+    {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "%s: Truncated chart snapshot file", filename);
+        return false;
+    }
 
-    // Draw maximum value
-    g_snprintf(value, sizeof(value), "%.0f", self->value_max);
-    cairo_set_font_size (cr, 25.0 * (w/650));
-    cairo_text_extents(cr, value, &extents);
-    cairo_move_to(cr, 0.77 * w - extents.width, 0.25 * h - extents.height/2);
-    cairo_save(cr);
-    cairo_scale(cr, 1, -1);
-    cairo_show_text(cr, value);
-    cairo_restore(cr);
+    // Every column must lie within the file before anything is replaced
+    size_t x_size = chart_storage_x_size(storage);
+    size_t y_size = chart_storage_y_size(storage);
+    const guint8 *x = NULL;
+    g_autofree const guint8 **ys = g_new0(const guint8 *, n_series);
+    gboolean valid = TRUE;
 
-    // Draw minimum line
-    gdk_cairo_set_source_rgba (cr, &self->axis_color);
-    cairo_move_to(cr, 0.08 * w, 0.25 * h);
-    cairo_line_to(cr, 0.22 * w, 0.25 * h);
-    cairo_set_line_width (cr, 1);
-    cairo_stroke (cr);
+    if (x_size > 0)
+    {
+        x = chart_binary_column(data, length, GUINT64_FROM_LE(header.x_offset), x_size, count);
+        valid = (x != NULL);
+    }
 
-    // Draw maximum line
-    cairo_move_to(cr, 0.78 * w, 0.25 * h);
-    cairo_line_to(cr, 0.92 * w, 0.25 * h);
-    cairo_set_line_width (cr, 1);
-    cairo_stroke (cr);
+    for (guint32 s = 0; valid && s < n_series; s++)
+    {
+        struct chart_binary_series_t series;
 
-    // Re-invert y-axis
-    cairo_scale(cr, 1, -1);
+        memcpy(&series, data + sizeof(header) + s * sizeof(series), sizeof(series));
+        ys[s] = chart_binary_column(data, length, GUINT64_FROM_LE(series.offset), y_size, count);
+        valid = (ys[s] != NULL);
+    }
 
-    // Draw arc
-    gdk_cairo_set_source_rgba (cr, &self->line_color);
-    double xc = 0.5 * w;
-    double yc = -0.25 * h;
-    double radius = 0.35 * w;
-    double angle1 = 180 * (M_PI/180.0);
-    double angle = self->value * (180 / (self->value_max));
-    double angle2 = 180 * (M_PI/180.0) + angle * (M_PI/180.0);
-    cairo_set_line_width (cr, 0.1 * w);
-    cairo_arc (cr, xc, yc, radius, angle1, angle2);
-    cairo_stroke (cr);
+    if (!valid)
+    {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "%s: Truncated chart snapshot file", filename);
+        return false;
+    }
 
-    cairo_destroy (cr);
-}
+    // Every series of the file gets drawn in its saved color
+    while (ring->n_series < n_series)
+    {
+        gtk_chart_add_series(chart, NULL);
+    }
 
-static void chart_draw_pie(GtkChart *self,
-                                     GtkSnapshot *snapshot,
-                                     float h,
-                                     float w)
-{
-    cairo_text_extents_t extents;
+    // Series 0 is drawn in the line color, the others have their own entry in series_list
+    GSList *l = chart->state.series_list;
+    for (guint32 s = 0; s < n_series; s++)
+    {
+        struct chart_binary_series_t series;
+        float rgba[4];
 
-    // Set up Cairo region
-    cairo_t *cr = gtk_snapshot_append_cairo(snapshot, &GRAPHENE_RECT_INIT(0, 0, w, h));
+        memcpy(&series, data + sizeof(header) + s * sizeof(series), sizeof(series));
+        for (unsigned int c = 0; c < 4; c++)
+        {
+            guint32 bits = GUINT32_FROM_LE(series.color[c]);
+            memcpy(&rgba[c], &bits, sizeof(bits));
+        }
 
-    cairo_set_antialias (cr, CAIRO_ANTIALIAS_FAST);
+        GdkRGBA *color = &chart->state.line_color;
+        if (s > 0)
+        {
+            color = &((struct chart_series_t *) l->data)->color;
+            l = l->next;
+        }
+        *color = (GdkRGBA) { rgba[0], rgba[1], rgba[2], rgba[3] };
+    }
 
-    // Center of chart
-    double cx = w / 2.0;
-    double cy = h / 2.0;
+    ring->x_start = chart_binary_read_double(header.x_start);
+    ring->x_step = x_step;
+    ring->x_base = 0;
+    ring->y_offset = chart_binary_read_double(header.y_offset);
+    ring->y_step = y_step;
+    chart->state.x_min = chart_binary_read_double(header.x_min);
+    chart->state.x_max = chart_binary_read_double(header.x_max);
+    chart->state.y_min = chart_binary_read_double(header.y_min);
+    chart->state.y_max = chart_binary_read_double(header.y_max);
+
+    // Columns are copied from the mapping straight into ring storage, the snapshot replaces
+    // any open series file as well
+    chart_ring_assign(ring, storage, x, ys, n_series, count);
+    chart_mapped_close(&chart->state.mapped);
+
+    chart->state.point_list_stale = TRUE;
+    chart->state.data_serial++;
+    chart->state.series_serial++;
+    chart_queue_redraw(chart);
 
-    double radius = MIN(w, h) / 2.5; // margin
+    return true;
+}
 
-    double total = 0.0;
-    GSList *l;
-    for(l = self->slice_list; l != NULL; l = l->next)
+// Parse number in [p, end). Up to 19 significant digits with a decimal exponent of at most 22 are
+// converted exactly with one multiplication or division, anything else goes through g_ascii_strtod().
+static gboolean chart_parse_double(const char *p, const char *end, double *value)
+{
+    static const double powers[] =
     {
-        struct chart_slice_t *slice = l->data;
-        total += slice->value;
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    const char *start = p;
+    gboolean negative = FALSE;
+    gboolean truncated = FALSE;
+    gboolean any = FALSE;
+    guint64 mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        negative = (*p == '-');
+        p++;
     }
 
-    if(total <= 0.0)
+    for (; p < end && g_ascii_isdigit(*p); p++)
     {
-        cairo_destroy(cr);
-        return;
+        any = TRUE;
+        if (digits < 19)
+        {
+            mantissa = mantissa * 10 + (guint64) (*p - '0');
+            digits += (mantissa != 0);
+        }
+        else
+        {
+            exponent++;
+            truncated |= (*p != '0');
+        }
     }
 
-    double start_angle = 0.0;
+    if (p < end && *p == '.')
+    {
+        for (p++; p < end && g_ascii_isdigit(*p); p++)
+        {
+            any = TRUE;
+            if (digits < 19)
+            {
+                mantissa = mantissa * 10 + (guint64) (*p - '0');
+                digits += (mantissa != 0);
+                exponent--;
+            }
+            else
+            {
+                truncated |= (*p != '0');
+            }
+        }
+    }
 
-    for (l = self->slice_list; l != NULL; l = l->next)
+    if (any && p < end && (*p == 'e' || *p == 'E') && p + 1 < end)
     {
-        struct chart_slice_t *slice = l->data;
+        const char *q = p + 1;
+        gboolean exponent_negative = (*q == '-');
+        int e = 0;
 
-        // Angle of the slice proportional to its value
-        double slice_angle = (slice->value / total) * 2.0 * G_PI;
+        q += (*q == '-' || *q == '+');
+        if (q < end && g_ascii_isdigit(*q))
+        {
+            for (; q < end && g_ascii_isdigit(*q); q++)
+            {
+                e = MIN(e * 10 + (*q - '0'), 100000);
+            }
+            exponent += exponent_negative ? -e : e;
+            p = q;
+        }
+    }
 
-        cairo_set_source_rgba(cr, slice->color.red, slice->color.green, slice->color.blue, slice->color.alpha);
+    if (any && p == end && !truncated && mantissa <= (G_GUINT64_CONSTANT(1) << 53) &&
+        exponent >= -22 && exponent <= 22)
+    {
+        double v = (double) mantissa;
 
-        cairo_move_to(cr, w / 2, h / 2);
-        cairo_arc(cr, w / 2, h / 2, radius, start_angle, start_angle + slice_angle);
-        cairo_close_path(cr);
-        cairo_fill(cr);
+        v = (exponent < 0) ? v / powers[-exponent] : v * powers[exponent];
+        *value = negative ? -v : v;
+        return TRUE;
+    }
 
-        if(slice->label != NULL) {
-            double middle = start_angle + slice_angle / 2.0;
-            double distance = radius + 20; // Position outside of the slide radius
+    // Long, huge, tiny or special values such as inf and nan
+    char buffer[64];
+    size_t length = end - start;
+    char *stop;
 
-            double lx = cx + cos(middle) * distance; // X = cx + cos(0) * radius
-            double ly = cy + sin(middle) * distance; // Y = cy + cos(0) * radius
+    if (length == 0 || length >= sizeof(buffer))
+    {
+        return FALSE;
+    }
 
-            cairo_set_source_rgba(cr, slice->color.red, slice->color.green, slice->color.blue, slice->color.alpha);
-            cairo_select_font_face(cr, self->font_name, CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
-            cairo_set_font_size(cr, 12);
-            cairo_text_extents(cr, slice->label, &extents);
+    memcpy(buffer, start, length);
+    buffer[length] = '\0';
+    *value = g_ascii_strtod(buffer, &stop);
 
-            // Adjust x position if angle is between 90º (PI/2) and 270º (3PI/2)
-            if(middle > G_PI / 2 && middle < 3 * G_PI / 2)
-            {
-                lx -= extents.width;
-            }
+    return stop == buffer + length;
+}
 
-            cairo_move_to(cr, lx, ly);
-            cairo_show_text(cr, slice->label);
-        }
+// Lines of CSV text between chunk boundaries, parsed into columns of x followed by one y per series
+struct chart_csv_chunk_t
+{
+    struct chart_job_t job;
+    const char *start;
+    const char *end;
+    char delimiter;
+    unsigned int n_columns;
+    GCancellable *cancellable;
+    double *columns;        // Column c of row i at c * capacity + i
+    size_t capacity;
+    size_t count;           // Rows parsed
+};
 
-        start_angle += slice_angle;
+struct chart_csv_data_t
+{
+    unsigned int n_columns;
+    unsigned int n_chunks;
+    struct chart_csv_chunk_t *chunks;
+};
+
+// Empty fields and missing trailing fields are NAN, rows without a numeric x such as headers are skipped
+static void chart_csv_chunk_run(struct chart_job_t *job)
+{
+    struct chart_csv_chunk_t *chunk = (struct chart_csv_chunk_t *) job;
+    const char *line = chunk->start;
+    size_t capacity = 1;
+
+    for (const char *p = chunk->start; (p = memchr(p, '\n', chunk->end - p)) != NULL; p++)
+    {
+        capacity++;
     }
+    chunk->capacity = capacity;
+    chunk->columns = g_new(double, (size_t) chunk->n_columns * capacity);
 
-    gdk_cairo_set_source_rgba (cr, &self->text_color);
-    cairo_select_font_face (cr, self->font_name, CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+    for (size_t n = 0; line < chunk->end; n++)
+    {
+        const char *eol = memchr(line, '\n', chunk->end - line);
+        const char *next = (eol != NULL) ? eol + 1 : chunk->end;
+        const char *field = line;
+        double *row = &chunk->columns[chunk->count];
+        gboolean valid = TRUE;
 
-    // Move coordinate system to bottom left
-    cairo_translate(cr, 0, h);
+        if (n % CHART_CSV_CANCEL_ROWS == 0 && g_cancellable_is_cancelled(chunk->cancellable))
+        {
+            return;
+        }
 
-    // Invert y-axis
-    cairo_scale(cr, 1, -1);
+        eol = (eol != NULL) ? eol : chunk->end;
+        if (eol > line && eol[-1] == '\r')
+        {
+            eol--;
+        }
 
-    // Draw title
-    cairo_set_font_size (cr, MIN(w, h) / 20);
-    cairo_text_extents(cr, self->title, &extents);
-    cairo_move_to (cr, 0.5 * w - extents.width/2, 0.95 * h - extents.height/2);
-    cairo_save(cr);
-    cairo_scale(cr, 1, -1);
-    cairo_show_text (cr, self->title);
+        for (unsigned int c = 0; c < chunk->n_columns; c++)
+        {
+            const char *stop = memchr(field, chunk->delimiter, eol - field);
+            double value = NAN;
 
-    cairo_destroy(cr);
+            stop = (stop != NULL) ? stop : eol;
+            if (!chart_parse_double(field, stop, &value))
+            {
+                value = NAN;
+                valid &= (c > 0);
+            }
+            row[c * capacity] = value;
+            field = (stop < eol) ? stop + 1 : eol;
+        }
+
+        chunk->count += valid;
+        line = next;
+    }
 }
 
-static void chart_draw_column(GtkChart *self,
-                              GtkSnapshot *snapshot,
-                              float h,
-                              float w)
+static void chart_csv_data_free(gpointer data)
 {
-    cairo_text_extents_t extents;
+    struct chart_csv_data_t *csv = data;
 
-    // Set up Cairo region
-    cairo_t *cr = gtk_snapshot_append_cairo(snapshot, &GRAPHENE_RECT_INIT(0, 0, w, h + 40));
+    for (unsigned int i = 0; i < csv->n_chunks; i++)
+    {
+        g_free(csv->chunks[i].columns);
+    }
+    g_free(csv->chunks);
+    g_free(csv);
+}
 
-    cairo_set_antialias (cr, CAIRO_ANTIALIAS_FAST);
+// Map file and parse it on the worker pool in chunks split at line boundaries
+static struct chart_csv_data_t * chart_csv_parse(const char *filename, char delimiter, GCancellable *cancellable,
+                                                 GError **error)
+{
+    g_autoptr (GMappedFile) file = g_mapped_file_new(filename, FALSE, error);
 
-    int n_total = g_slist_length(self->column_list);
-    if(n_total == 0) {
-        cairo_destroy(cr);
-        return;
+    if (file == NULL)
+    {
+        return NULL;
     }
 
-    float spacing = (w * 0.05) * (n_total + 1);
-    float column_width = (w - spacing) / n_total;
+    const char *data = g_mapped_file_get_contents(file);
+    size_t length = g_mapped_file_get_length(file);
+    const char *end = data + length;
+    struct chart_csv_data_t *csv = g_new0(struct chart_csv_data_t, 1);
+    const char *line = data;
 
-    double max_value = 0.0;
-    GSList *l;
-    for(l = self->column_list; l != NULL; l = l->next)
+    // Columns of first non-empty line, which may be a header
+    while (line < end && (*line == '\n' || *line == '\r'))
     {
-        struct chart_column_t *column = l->data;
-        if (column->value > max_value) max_value = column->value;
+        line++;
     }
-
-    if(max_value <= 0.0)
+    if (line == end)
     {
-        cairo_destroy(cr);
-        return;
+        return csv;
     }
 
-    float y_scale = (h - (0.1 * h) - (0.1 * h)) / max_value;
-    int i = 0;
-
-    double ticks = max_value / self->ticks;
+    const char *eol = memchr(line, '\n', end - line);
+    csv->n_columns = 1;
+    for (const char *p = line; p < (eol != NULL ? eol : end); p++)
+    {
+        csv->n_columns += (*p == delimiter);
+    }
 
-    for(int i = 0; i <= self->ticks; i++)
+    if (csv->n_columns < 2)
     {
-        double value = i * ticks;
-        float y_tick = h - 0.1 * h - value * y_scale;
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "%s: No y column in CSV file", filename);
+        chart_csv_data_free(csv);
+        return NULL;
+    }
 
-        char label[64];
-        snprintf(label, sizeof(label), "%.0f", value);
+    csv->n_chunks = (unsigned int) MAX(length / CHART_CSV_CHUNK_SIZE, 1);
+    csv->chunks = g_new0(struct chart_csv_chunk_t, csv->n_chunks);
 
-        // Draw ticks value
-        cairo_set_source_rgba(cr, 0.6, 0.6, 0.6, 0.8);
-        cairo_select_font_face(cr, self->font_name, CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
-        cairo_set_font_size(cr, 12);
+    const char *start = line;
+    for (unsigned int i = 0; i < csv->n_chunks; i++)
+    {
+        struct chart_csv_chunk_t *chunk = &csv->chunks[i];
+        const char *stop = end;
 
-        cairo_move_to(cr, 5, y_tick);
-        cairo_show_text(cr, label);
+        if (i + 1 < csv->n_chunks)
+        {
+            // Chunk ends after the line crossing its share of the file
+            stop = MAX(data + (i + 1) * (length / csv->n_chunks), start);
+            stop = memchr(stop, '\n', end - stop);
+            stop = (stop != NULL) ? stop + 1 : end;
+        }
 
-        // Draw line horizontal
-        cairo_set_source_rgba(cr, 0.6, 0.6, 0.6, 0.3);
-        cairo_move_to(cr, 30, y_tick);
-        cairo_line_to(cr, w, y_tick);
-        cairo_stroke(cr);
+        chunk->job.run = chart_csv_chunk_run;
+        chunk->start = start;
+        chunk->end = stop;
+        chunk->delimiter = delimiter;
+        chunk->n_columns = csv->n_columns;
+        chunk->cancellable = cancellable;
+        start = stop;
     }
 
-    for (l = self->column_list; l != NULL; l = l->next)
+    // One chunk per pool thread at a time, so tiles and density jobs queued meanwhile only wait
+    // for the chunks already running instead of the whole file
+    unsigned int wave = chart_pool_n_threads();
+    for (unsigned int i = 0; i < csv->n_chunks && !g_cancellable_is_cancelled(cancellable); i += wave)
     {
-        struct chart_column_t *column = l->data;
-
-
-        float column_height = column->value * y_scale;
-        if(column_height < 2.0f) { // value = 0
-            column_height = 2.0f;
-        }
+        chart_pool_run(&csv->chunks[i], sizeof(csv->chunks[0]), MIN(wave, csv->n_chunks - i));
+    }
 
-        float x = (w * 0.05) + i * (column_width + (w * 0.05));
-        float y = h - (0.1 * h) - column_height;
-        i++;
+    if (g_cancellable_set_error_if_cancelled(cancellable, error))
+    {
+        chart_csv_data_free(csv);
+        return NULL;
+    }
 
-        // Draw Column
-        cairo_set_source_rgba(cr, column->color.red, column->color.green, column->color.blue, column->color.alpha);
+    return csv;
+}
 
-        cairo_rectangle(cr, x, y, column_width, column_height);
-        cairo_fill(cr);
+// Append parsed rows, one block per chunk
+static void chart_csv_append(GtkChart *chart, const struct chart_csv_data_t *csv)
+{
+    unsigned int n_series = (csv->n_columns > 0) ? csv->n_columns - 1 : 0;
+    g_autofree const double **ys = g_new(const double *, MAX(n_series, 1));
 
-        if(column->label != NULL) {
-            // Draw Label
-            cairo_set_source_rgba(cr, 0.6, 0.6, 0.6, 0.8);
-            cairo_select_font_face(cr, self->font_name, CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
-            cairo_set_font_size(cr, 12);
-            cairo_text_extents(cr, column->label, &extents);
+    // Every column of the file gets drawn
+    while (chart->state.points.n_series < n_series)
+    {
+        gtk_chart_add_series(chart, NULL);
+    }
 
-            float label_x = x + column_width / 2;
-            float label_y = h - (w * 0.03) + 20;
+    for (unsigned int i = 0; i < csv->n_chunks; i++)
+    {
+        const struct chart_csv_chunk_t *chunk = &csv->chunks[i];
 
-            cairo_save(cr);
-            cairo_translate(cr, label_x, label_y);
-            cairo_rotate(cr, -M_PI / 3); // rotate -60º (-PI/3)
+        if (chunk->count == 0)
+        {
+            continue;
+        }
 
-            cairo_move_to(cr, -extents.width / 2, -extents.height);
-            cairo_show_text(cr, column->label);
-            cairo_restore(cr);
+        for (unsigned int s = 0; s < n_series; s++)
+        {
+            ys[s] = &chunk->columns[(s + 1) * chunk->capacity];
         }
+        chart_ring_push_block(&chart->state.points, chunk->columns, ys, n_series, chunk->count);
     }
 
-    gdk_cairo_set_source_rgba (cr, &self->text_color);
-    cairo_select_font_face (cr, self->font_name, CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+    chart->state.point_list_stale = TRUE;
+    chart_queue_redraw(chart);
+}
+
+EXPORT bool gtk_chart_load_csv(GtkChart *chart, const char *filename, GError **error)
+{
+    g_assert_nonnull(chart);
+    g_assert_nonnull(filename);
 
-    // Move coordinate system to bottom left
-    cairo_translate(cr, 0, h);
+    struct chart_csv_data_t *csv = chart_csv_parse(filename, chart->state.csv_delimiter, NULL, error);
 
-    // Invert y-axis
-    cairo_scale(cr, 1, -1);
+    if (csv == NULL)
+    {
+        return false;
+    }
 
-    // Draw title
-    cairo_set_font_size (cr, MIN(w, h) / 20);
-    cairo_text_extents(cr, self->title, &extents);
-    cairo_move_to (cr, 0.5 * w - extents.width/2, 0.95 * h - extents.height/2);
-    cairo_save(cr);
-    cairo_scale(cr, 1, -1);
-    cairo_show_text (cr, self->title);
+    chart_csv_append(chart, csv);
+    chart_csv_data_free(csv);
 
-    cairo_destroy(cr);
+    return true;
 }
 
-static void chart_draw_unknown_type(GtkChart *self,
-                                    GtkSnapshot *snapshot,
-                                    float h,
-                                    float w)
+struct chart_csv_load_t
 {
-    UNUSED(self);
+    char *filename;
+    char delimiter;
+};
 
-    cairo_text_extents_t extents;
-    const char *warning = "Unknown chart type";
+static void chart_csv_load_free(gpointer data)
+{
+    struct chart_csv_load_t *load = data;
 
-    // Set up Cairo region
-    cairo_t * cr = gtk_snapshot_append_cairo (snapshot, &GRAPHENE_RECT_INIT(0, 0, w, h));
-    gdk_cairo_set_source_rgba (cr, &self->text_color);
-    cairo_select_font_face (cr, self->font_name, CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+    g_free(load->filename);
+    g_free(load);
+}
 
-    // Move coordinate system to bottom left
-    cairo_translate(cr, 0, h);
+static void chart_load_csv_thread(GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable)
+{
+    struct chart_csv_load_t *load = task_data;
+    GError *error = NULL;
+    struct chart_csv_data_t *csv;
 
-    // Invert y-axis
-    cairo_scale(cr, 1, -1);
+    UNUSED(source_object);
 
-    // Draw title
-    double title_font_size = 0.05 * h;  // 5% of total height
-    cairo_set_font_size (cr, title_font_size);
-    cairo_text_extents(cr, warning, &extents);
-    cairo_move_to (cr, 0.5 * w - extents.width/2, 0.5 * h - extents.height/2);
-    cairo_save(cr);
-    cairo_scale(cr, 1, -1);
-    cairo_show_text (cr, warning);
-    cairo_restore(cr);
+    csv = chart_csv_parse(load->filename, load->delimiter, cancellable, &error);
+    if (csv == NULL)
+    {
+        g_task_return_error(task, error);
+        return;
+    }
 
-    cairo_destroy (cr);
+    g_task_return_pointer(task, csv, chart_csv_data_free);
 }
 
+// Parse on a worker thread, the rows are appended by gtk_chart_load_csv_finish()
+EXPORT void gtk_chart_load_csv_async(GtkChart *chart,
+                                     const char *filename,
+                                     GCancellable *cancellable,
+                                     GAsyncReadyCallback callback,
+                                     gpointer user_data)
+{
+    g_assert_nonnull(chart);
+    g_assert_nonnull(filename);
 
-static void gtk_chart_snapshot (GtkWidget   *widget,
-                                GtkSnapshot *snapshot)
+    struct chart_csv_load_t *load = g_new0(struct chart_csv_load_t, 1);
+    GTask *task = g_task_new(chart, cancellable, callback, user_data);
+
+    load->filename = g_strdup(filename);
+    load->delimiter = chart->state.csv_delimiter;
+    g_task_set_source_tag(task, gtk_chart_load_csv_async);
+    g_task_set_task_data(task, load, chart_csv_load_free);
+    g_task_run_in_thread(task, chart_load_csv_thread);
+    g_object_unref(task);
+}
+
+EXPORT bool gtk_chart_load_csv_finish(GtkChart *chart, GAsyncResult *result, GError **error)
 {
-    GtkChart *self = GTK_CHART(widget);
+    g_assert_nonnull(chart);
+    g_return_val_if_fail(g_task_is_valid(result, chart), false);
 
-    float width = gtk_widget_get_width (widget);
-    float height = gtk_widget_get_height (widget);
+    struct chart_csv_data_t *csv = g_task_propagate_pointer(G_TASK(result), error);
 
-    // Automatically update colors if none set
-    GtkStyleContext *context = gtk_widget_get_style_context(&self->parent_instance);
-    if (self->text_color.alpha == -1.0)
+    if (csv == NULL)
     {
-        gtk_style_context_get_color(context, &self->text_color);
+        return false;
     }
-    if (self->line_color.alpha == -1.0)
+
+    chart_csv_append(chart, csv);
+    chart_csv_data_free(csv);
+
+    return true;
+}
+
+EXPORT GSList * gtk_chart_get_points(GtkChart *chart)
+{
+    const struct chart_ring_t *ring = &chart->state.points;
+
+    if (!chart->state.point_list_stale)
     {
-        gtk_style_context_lookup_color (context, "theme_selected_bg_color", &self->line_color);
+        return chart->state.point_list;
     }
-    if (self->grid_color.alpha == -1.0)
+
+    // Rebuild list view of ring buffer, owned by chart until next change
+    g_clear_slist(&chart->state.point_list, NULL);
+    g_free(chart->state.point_cache);
+    chart->state.point_cache = g_new(struct chart_point_t, MAX(ring->count, 1));
+
+    for (size_t i = ring->count; i > 0; i--)
     {
-        gtk_style_context_get_color(context, &self->grid_color);
-        self->grid_color.alpha = 0.1;
+        size_t slot = chart_ring_slot(ring, i - 1);
+        chart->state.point_cache[i - 1].x = chart_ring_x(ring, slot);
+        chart->state.point_cache[i - 1].y = chart_ring_y(ring, 0, slot);
+        chart->state.point_list = g_slist_prepend(chart->state.point_list, &chart->state.point_cache[i - 1]);
     }
-    if (self->axis_color.alpha == -1.0)
+
+    chart->state.point_list_stale = FALSE;
+
+    return chart->state.point_list;
+}
+
+EXPORT void gtk_chart_set_capacity(GtkChart *chart, size_t capacity)
+{
+    g_assert_nonnull(chart);
+
+    struct chart_ring_t *ring = &chart->state.points;
+
+    ring->capacity = capacity;
+
+    // Preallocate bounded storage so appends never allocate
+    if (capacity != 0 && ring->size != capacity)
     {
-        gtk_style_context_get_color(context, &self->axis_color);
+        chart_ring_resize(ring, capacity);
+        chart->state.point_list_stale = TRUE;
     }
+}
 
-    // Draw various chart types
-    switch (self->type)
-    {
-        case GTK_CHART_TYPE_LINE:
-        case GTK_CHART_TYPE_SCATTER:
-            chart_draw_line_or_scatter(self, snapshot, height, width);
-            break;
+EXPORT size_t gtk_chart_get_capacity(GtkChart *chart)
+{
+    return chart->state.points.capacity;
+}
 
-        case GTK_CHART_TYPE_NUMBER:
-            chart_draw_number(self, snapshot, height, width);
-            break;
+EXPORT size_t gtk_chart_get_n_points(GtkChart *chart)
+{
+    return chart->state.points.count;
+}
 
-        case GTK_CHART_TYPE_GAUGE_LINEAR:
-            chart_draw_gauge_linear(self, snapshot, height, width);
-            break;
+EXPORT bool gtk_chart_open_series_file(GtkChart *chart, const char *path, GError **error)
+{
+    struct chart_mapped_t mapped = { 0 };
 
-        case GTK_CHART_TYPE_GAUGE_ANGULAR:
-            chart_draw_gauge_angular(self, snapshot, height, width);
-            break;
+    g_assert_nonnull(chart);
+    g_assert_nonnull(path);
 
-        case GTK_CHART_TYPE_PIE:
-            chart_draw_pie(self, snapshot, height, width);
-            break;
+    if (!chart_mapped_open(&mapped, path, error))
+    {
+        return false;
+    }
 
-        case GTK_CHART_TYPE_COLUMN:
-            chart_draw_column(self, snapshot, height, width);
-            break;
+    chart_mapped_close(&chart->state.mapped);
+    chart->state.mapped = mapped;
 
-        default:
-            chart_draw_unknown_type(self, snapshot, height, width);
-            break;
+    // Every series of the file gets drawn
+    while (chart->state.points.n_series < mapped.n_series)
+    {
+        gtk_chart_add_series(chart, NULL);
     }
 
-    self->snapshot = snapshot;
+    chart->state.data_serial++;
+    chart_queue_redraw(chart);
+
+    return true;
 }
 
-static void gtk_chart_class_init (GtkChartClass *class)
+EXPORT void gtk_chart_close_series_file(GtkChart *chart)
 {
-    GObjectClass *object_class = G_OBJECT_CLASS (class);
-    GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (class);
+    g_assert_nonnull(chart);
 
-    object_class->finalize = gtk_chart_finalize;
-    object_class->dispose = gtk_chart_dispose;
+    chart_mapped_close(&chart->state.mapped);
+    chart->state.data_serial++;
 
-    widget_class->snapshot = gtk_chart_snapshot;
+    chart_queue_redraw(chart);
 }
 
-EXPORT GtkWidget * gtk_chart_new (void)
+EXPORT void gtk_chart_set_history(GtkChart *chart, size_t capacity)
 {
+    g_assert_nonnull(chart);
 
-    return g_object_new (GTK_TYPE_CHART, NULL);
-}
+    // Points evicted from the ring buffer are compressed instead of discarded
+    chart_history_set_capacity(&chart->state.points.history, capacity);
+    chart->state.data_serial++;
 
-EXPORT void gtk_chart_set_user_data(GtkChart *chart, void *user_data)
-{
-    chart->user_data = user_data;
+    chart_queue_redraw(chart);
 }
 
-EXPORT void * gtk_chart_get_user_data(GtkChart *chart)
+EXPORT size_t gtk_chart_get_history(GtkChart *chart)
 {
-    return chart->user_data;
+    return chart->state.points.history.capacity;
 }
 
-EXPORT void gtk_chart_set_type(GtkChart *chart, GtkChartType type)
+EXPORT size_t gtk_chart_get_history_n_points(GtkChart *chart)
 {
-    chart->type = type;
+    return chart_history_n_points(&chart->state.points.history);
 }
 
-EXPORT void gtk_chart_set_title(GtkChart *chart, const char *title)
+EXPORT size_t gtk_chart_get_history_bytes(GtkChart *chart)
 {
+    const struct chart_history_t *history = &chart->state.points.history;
+    size_t bytes = history->bytes;
 
-    g_assert_nonnull(chart);
-    g_assert_nonnull(title);
-
-    if (chart->title != NULL)
+    // Open block is kept uncompressed
+    if (history->blocks != NULL)
     {
-        g_free(chart->title);
+        bytes += CHART_HISTORY_BLOCK * sizeof(double) * (1 + MAX(chart->state.points.n_series, 1));
     }
 
-    chart->title = g_strdup(title);
+    return bytes;
 }
 
-EXPORT void gtk_chart_set_label(GtkChart *chart, const char *label)
+EXPORT bool gtk_chart_save_png(GtkChart *chart, const char *filename, GError **error)
 {
-    g_assert_nonnull(chart);
-    g_assert_nonnull(label);
+    int width = gtk_widget_get_width (GTK_WIDGET(chart));
+    int height = gtk_widget_get_height (GTK_WIDGET(chart));
 
-    if (chart->label != NULL)
-    {
-        g_free(chart->label);
-    }
+    // Get to the PNG image file from paintable
+    GdkPaintable *paintable = gtk_widget_paintable_new (GTK_WIDGET(chart));
+    GtkSnapshot *snapshot = gtk_snapshot_new ();
+    gdk_paintable_snapshot (paintable, snapshot, width, height);
+    GskRenderNode *node = gtk_snapshot_free_to_node (snapshot);
+    GskRenderer *renderer = gsk_cairo_renderer_new ();
+    if (!gsk_renderer_realize (renderer, NULL, error))
+      return false;
+    GdkTexture *texture = gsk_renderer_render_texture (renderer, node, NULL);
+    gdk_texture_save_to_png (texture, filename);
+
+    // Cleanup
+    g_object_unref(texture);
+    gsk_renderer_unrealize(renderer);
+    g_object_unref(renderer);
+    gsk_render_node_unref(node);
+    g_object_unref(paintable);
 
-    chart->label = g_strdup(label);
+    return true;
 }
 
-EXPORT void gtk_chart_set_x_label(GtkChart *chart, const char *x_label)
+static GSList * chart_slices_copy(GSList *list)
 {
-    g_assert_nonnull(chart);
-    g_assert_nonnull(x_label);
+    GSList *copy = NULL;
 
-    if (chart->x_label != NULL)
+    for (GSList *l = list; l != NULL; l = l->next)
     {
-        g_free(chart->x_label);
+        struct chart_slice_t *slice = g_memdup2(l->data, sizeof(struct chart_slice_t));
+
+        slice->label = g_strdup(slice->label);
+        copy = g_slist_prepend(copy, slice);
     }
 
-    chart->x_label = g_strdup(x_label);
+    return g_slist_reverse(copy);
 }
 
-EXPORT void gtk_chart_set_y_label(GtkChart *chart, const char *y_label)
+static GSList * chart_columns_copy(GSList *list)
 {
-    g_assert_nonnull(chart);
-    g_assert_nonnull(y_label);
+    GSList *copy = NULL;
 
-    if (chart->y_label != NULL)
+    for (GSList *l = list; l != NULL; l = l->next)
     {
-        g_free(chart->y_label);
+        struct chart_column_t *column = g_memdup2(l->data, sizeof(struct chart_column_t));
+
+        column->label = g_strdup(column->label);
+        copy = g_slist_prepend(copy, column);
     }
 
-    chart->y_label = g_strdup(y_label);
+    return g_slist_reverse(copy);
 }
 
-EXPORT void gtk_chart_set_x_max(GtkChart *chart, double x_max)
+static void chart_slice_free(gpointer data)
 {
-    chart->x_max = x_max;
-}
+    struct chart_slice_t *slice = data;
 
-EXPORT void gtk_chart_set_y_max(GtkChart *chart, double y_max)
-{
-    chart->y_max = y_max;
+    g_free(slice->label);
+    g_free(slice);
 }
 
-EXPORT void gtk_chart_set_x_min(GtkChart *chart, double x_min)
+static void chart_column_free(gpointer data)
 {
-    chart->x_min = x_min;
-}
+    struct chart_column_t *column = data;
 
-EXPORT void gtk_chart_set_y_min(GtkChart *chart, double y_min)
-{
-    chart->y_min = y_min;
+    g_free(column->label);
+    g_free(column);
 }
 
-EXPORT void gtk_chart_set_width(GtkChart *chart, int width)
+static void chart_export_free(gpointer data)
 {
-    chart->width = width;
+    struct chart_export_t *export = data;
+    struct chart_state_t *copy = &export->state;
+
+    g_free(copy->title);
+    g_free(copy->label);
+    g_free(copy->x_label);
+    g_free(copy->y_label);
+    g_free(copy->font_name);
+    chart_ring_free(&copy->points);
+    chart_mapped_close(&copy->mapped);
+    g_clear_pointer(&copy->marker.surface, cairo_surface_destroy);
+    g_clear_object(&copy->marker.texture);
+    g_slist_free_full(copy->series_list, chart_series_free);
+    g_slist_free_full(copy->slice_list, chart_slice_free);
+    g_slist_free_full(copy->column_list, chart_column_free);
+
+    chart_text_cache_clear(&export->text_cache);
+    g_free(export->filename);
+    g_free(export);
 }
 
-EXPORT void gtk_chart_plot_point(GtkChart *chart, double x, double y)
+// Snapshot everything drawing reads, so a worker thread can render while the chart keeps changing
+static struct chart_export_t * chart_export_new(GtkChart *chart)
 {
-    // Allocate memory for new point
-    struct chart_point_t *point = g_new0(struct chart_point_t, 1);
-    point->x = x;
-    point->y = y;
+    struct chart_export_t *export = g_new0(struct chart_export_t, 1);
+    struct chart_state_t *copy = &export->state;
+    const struct chart_state_t *state = &chart->state;
+
+    chart_resolve_colors(chart);
+    *copy = *state;
+    export->scale = gtk_widget_get_scale_factor(GTK_WIDGET(chart));
+    export->width = gtk_widget_get_width(GTK_WIDGET(chart));
+    export->height = gtk_widget_get_height(GTK_WIDGET(chart));
+
+    copy->export = export;
+    copy->scale = export->scale;
+    copy->pango_context = NULL;
+    copy->title = g_strdup(state->title);
+    copy->label = g_strdup(state->label);
+    copy->x_label = g_strdup(state->x_label);
+    copy->y_label = g_strdup(state->y_label);
+    copy->font_name = g_strdup(state->font_name);
+    copy->axes_node = NULL;
+    copy->axes_valid = FALSE;
+    copy->point_cache = NULL;
+    copy->point_list = NULL;
+    copy->marker.surface = NULL;
+    copy->marker.texture = NULL;
+    memset(&copy->strip, 0, sizeof(copy->strip));
+    chart_ring_copy(&copy->points, &state->points);
+    copy->slice_list = chart_slices_copy(state->slice_list);
+    copy->column_list = chart_columns_copy(state->column_list);
+
+    copy->series_list = NULL;
+    for (GSList *l = state->series_list; l != NULL; l = l->next)
+    {
+        struct chart_series_t *series = g_new0(struct chart_series_t, 1);
 
-    // Add point to list to be drawn
-    chart->point_list = g_slist_append(chart->point_list, point);
+        series->color = ((struct chart_series_t *) l->data)->color;
+        copy->series_list = g_slist_prepend(copy->series_list, series);
+    }
+    copy->series_list = g_slist_reverse(copy->series_list);
 
-    // Queue draw of widget
-    if (GTK_IS_WIDGET(chart))
+    if (state->mapped.file != NULL)
     {
-        gtk_widget_queue_draw(GTK_WIDGET(chart));
+        g_mapped_file_ref(state->mapped.file);
+        copy->mapped.blocks = g_memdup2(state->mapped.blocks,
+                                        MAX(state->mapped.n_blocks, 1) * sizeof(struct chart_mapped_block_t));
+        copy->mapped.columns = g_memdup2(state->mapped.columns, MAX(state->mapped.n_blocks * state->mapped.n_series, 1) *
+                                         sizeof(struct chart_mapped_column_t));
     }
+
+    return export;
 }
 
-EXPORT void gtk_chart_add_slice(GtkChart *chart, double value, const char *color, const char *label)
+static void chart_save_png_thread(GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable)
 {
-    // Allocate memory for new slice
-    struct chart_slice_t *slice = g_new0(struct chart_slice_t, 1);
-    slice->value = value;
-    gdk_rgba_parse(&slice->color, color);
-    if(label != NULL) slice->label = g_strdup(label);
+    struct chart_export_t *export = task_data;
+    cairo_surface_t *surface;
+    cairo_status_t status;
 
-    // Add slice to list to be drawn
-    chart->slice_list = g_slist_append(chart->slice_list, slice);
+    UNUSED(source_object);
 
-    // Queue draw of widget
-    if (GTK_IS_WIDGET(chart))
-    {
-        gtk_widget_queue_draw(GTK_WIDGET(chart));
-    }
-}
+    surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
+                                         MAX(export->width, 1) * export->scale,
+                                         MAX(export->height, 1) * export->scale);
+    cairo_surface_set_device_scale(surface, export->scale, export->scale);
+    export->cr = cairo_create(surface);
 
-EXPORT void gtk_chart_add_column(GtkChart *chart, double value, const char *color, const char *label)
-{
-    // Allocate memory for new column
-    struct chart_column_t *column = g_new0(struct chart_column_t, 1);
-    column->value = value;
-    gdk_rgba_parse(&column->color, color);
-    if(label != NULL)  column->label = g_strdup(label);
+    chart_draw(&export->state, NULL, export->height, export->width);
 
-    // Add column to list to be drawn
-    chart->column_list = g_slist_append(chart->column_list, column);
+    g_clear_pointer(&export->cr, cairo_destroy);
 
-    // Queue draw of widget
-    if (GTK_IS_WIDGET(chart))
+    if (g_task_return_error_if_cancelled(task))
     {
-        gtk_widget_queue_draw(GTK_WIDGET(chart));
+        cairo_surface_destroy(surface);
+        return;
     }
-}
 
-EXPORT void gtk_chart_set_value(GtkChart *chart, double value)
-{
-    chart->value = value;
+    status = cairo_surface_write_to_png(surface, export->filename);
+    cairo_surface_destroy(surface);
 
-    // Queue draw of widget
-    if (GTK_IS_WIDGET(chart))
+    if (status != CAIRO_STATUS_SUCCESS)
     {
-        gtk_widget_queue_draw(GTK_WIDGET(chart));
+        g_task_return_new_error(task, G_IO_ERROR, G_IO_ERROR_FAILED,
+                                "Failed to write %s: %s", export->filename, cairo_status_to_string(status));
+        return;
     }
-}
 
-EXPORT void gtk_chart_set_value_min(GtkChart *chart, double value)
-{
-    chart->value_min = value;
+    g_task_return_boolean(task, TRUE);
 }
 
-EXPORT void gtk_chart_set_value_max(GtkChart *chart, double value)
+EXPORT void gtk_chart_save_png_async(GtkChart *chart,
+                                     const char *filename,
+                                     GCancellable *cancellable,
+                                     GAsyncReadyCallback callback,
+                                     gpointer user_data)
 {
-    chart->value_max = value;
+    g_assert_nonnull(chart);
+    g_assert_nonnull(filename);
+
+    struct chart_export_t *export = chart_export_new(chart);
+    GTask *task = g_task_new(chart, cancellable, callback, user_data);
+
+    export->filename = g_strdup(filename);
+    g_task_set_source_tag(task, gtk_chart_save_png_async);
+    g_task_set_task_data(task, export, chart_export_free);
+    g_task_run_in_thread(task, chart_save_png_thread);
+    g_object_unref(task);
 }
 
-EXPORT double gtk_chart_get_value_min(GtkChart *chart)
+EXPORT bool gtk_chart_save_png_finish(GtkChart *chart, GAsyncResult *result, GError **error)
 {
-    return chart->value_min;
+    g_assert_nonnull(chart);
+    g_return_val_if_fail(g_task_is_valid(result, chart), false);
+
+    return g_task_propagate_boolean(G_TASK(result), error);
 }
 
-EXPORT double gtk_chart_get_value_max(GtkChart *chart)
+struct chart_csv_task_t
 {
-    return chart->value_max;
-}
+    struct chart_export_t *export;
+    GOutputStream *stream;
+    GFileProgressCallback progress;
+    gpointer progress_data;
+    GMainContext *context;
+};
 
-EXPORT double gtk_chart_get_x_max(GtkChart *chart)
+struct chart_csv_progress_t
 {
-    return chart->x_max;
-}
+    GFileProgressCallback progress;
+    gpointer progress_data;
+    goffset rows;
+    goffset total;
+};
 
-EXPORT double gtk_chart_get_x_min(GtkChart *chart)
+static void chart_csv_task_free(gpointer data)
 {
-    return chart->x_min;
+    struct chart_csv_task_t *csv = data;
+
+    chart_export_free(csv->export);
+    g_object_unref(csv->stream);
+    g_main_context_unref(csv->context);
+    g_free(csv);
 }
 
-EXPORT double gtk_chart_get_y_max(GtkChart *chart)
+static gboolean chart_csv_progress_dispatch(gpointer data)
 {
-    return chart->y_max;
+    struct chart_csv_progress_t *report = data;
+
+    report->progress(report->rows, report->total, report->progress_data);
+
+    return G_SOURCE_REMOVE;
 }
 
-EXPORT double gtk_chart_get_y_min(GtkChart *chart)
+// Called on worker thread, report rows written in context of caller
+static void chart_csv_progress(struct chart_csv_writer_t *writer)
 {
-    return chart->y_min;
+    struct chart_csv_task_t *csv = writer->progress_data;
+    struct chart_csv_progress_t *report = g_new(struct chart_csv_progress_t, 1);
+
+    report->progress = csv->progress;
+    report->progress_data = csv->progress_data;
+    report->rows = writer->rows;
+    report->total = writer->total;
+    g_main_context_invoke_full(csv->context, G_PRIORITY_DEFAULT, chart_csv_progress_dispatch, report, g_free);
 }
 
-EXPORT bool gtk_chart_save_csv(GtkChart *chart, const char *filename, GError **error)
+static void chart_write_csv_thread(GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable)
 {
-    struct chart_point_t *point;
-    GSList *l;
-    g_autoptr (GString) csv;
+    struct chart_csv_task_t *csv = task_data;
+    struct chart_state_t *copy = &csv->export->state;
+    GError *error = NULL;
 
-    csv = g_string_new(NULL);
+    UNUSED(source_object);
 
-    for (l = chart->point_list; l != NULL; l = l->next)
+    struct chart_csv_writer_t writer =
+    {
+        .stream = csv->stream,
+        .cancellable = cancellable,
+        .precision = copy->csv_precision,
+        .delimiter = copy->csv_delimiter,
+        .progress = (csv->progress != NULL) ? chart_csv_progress : NULL,
+        .progress_data = csv,
+    };
+
+    if (!chart_csv_write(copy, &writer, &error))
     {
-        point = l->data;
-        g_string_append_printf(csv, "%f,%f\n", point->x, point->y);
+        g_task_return_error(task, error);
+        return;
     }
 
-    return g_file_set_contents(filename, csv->str, csv->len, error);
+    g_task_return_boolean(task, TRUE);
 }
 
-EXPORT GSList * gtk_chart_get_points(GtkChart *chart)
+// Write CSV of a snapshot of the data on a worker thread, progress is reported in rows
+EXPORT void gtk_chart_write_csv_async(GtkChart *chart,
+                                      GOutputStream *stream,
+                                      GCancellable *cancellable,
+                                      GFileProgressCallback progress_callback,
+                                      gpointer progress_data,
+                                      GAsyncReadyCallback callback,
+                                      gpointer user_data)
 {
-  return chart->point_list;
+    g_assert_nonnull(chart);
+    g_return_if_fail(G_IS_OUTPUT_STREAM(stream));
+
+    struct chart_csv_task_t *csv = g_new0(struct chart_csv_task_t, 1);
+    GTask *task = g_task_new(chart, cancellable, callback, user_data);
+
+    csv->export = chart_export_new(chart);
+    csv->stream = g_object_ref(stream);
+    csv->progress = progress_callback;
+    csv->progress_data = progress_data;
+    csv->context = g_main_context_ref(g_task_get_context(task));
+    g_task_set_source_tag(task, gtk_chart_write_csv_async);
+    g_task_set_task_data(task, csv, chart_csv_task_free);
+    g_task_run_in_thread(task, chart_write_csv_thread);
+    g_object_unref(task);
 }
 
-EXPORT bool gtk_chart_save_png(GtkChart *chart, const char *filename, GError **error)
+EXPORT bool gtk_chart_write_csv_finish(GtkChart *chart, GAsyncResult *result, GError **error)
 {
-    int width = gtk_widget_get_width (GTK_WIDGET(chart));
-    int height = gtk_widget_get_height (GTK_WIDGET(chart));
-
-    // Get to the PNG image file from paintable
-    GdkPaintable *paintable = gtk_widget_paintable_new (GTK_WIDGET(chart));
-    GtkSnapshot *snapshot = gtk_snapshot_new ();
-    gdk_paintable_snapshot (paintable, snapshot, width, height);
-    GskRenderNode *node = gtk_snapshot_free_to_node (snapshot);
-    GskRenderer *renderer = gsk_cairo_renderer_new ();
-    if (!gsk_renderer_realize (renderer, NULL, error))
-      return false;
-    GdkTexture *texture = gsk_renderer_render_texture (renderer, node, NULL);
-    gdk_texture_save_to_png (texture, filename);
-
-    // Cleanup
-    g_object_unref(texture);
-    gsk_renderer_unrealize(renderer);
-    g_object_unref(renderer);
-    gsk_render_node_unref(node);
-    g_object_unref(paintable);
+    g_assert_nonnull(chart);
+    g_return_val_if_fail(g_task_is_valid(result, chart), false);
 
-    return true;
+    return g_task_propagate_boolean(G_TASK(result), error);
 }
 
 EXPORT bool gtk_chart_set_color(GtkChart *chart, char *name, char *color)
@@ -1271,19 +7827,19 @@ EXPORT bool gtk_chart_set_color(GtkChart *chart, char *name, char *color)
 
     if (strcmp(name, "text_color") == 0)
     {
-        return gdk_rgba_parse(&chart->text_color, color);
+        return gdk_rgba_parse(&chart->state.text_color, color);
     }
     else if (strcmp(name, "line_color") == 0)
     {
-        return gdk_rgba_parse(&chart->line_color, color);
+        return gdk_rgba_parse(&chart->state.line_color, color);
     }
     else if (strcmp(name, "grid_color") == 0)
     {
-        return gdk_rgba_parse(&chart->grid_color, color);
+        return gdk_rgba_parse(&chart->state.grid_color, color);
     }
     else if (strcmp(name, "axis_color") == 0)
     {
-        return gdk_rgba_parse(&chart->axis_color, color);
+        return gdk_rgba_parse(&chart->state.axis_color, color);
     }
 
     return false;
@@ -1294,12 +7850,13 @@ EXPORT void gtk_chart_set_font(GtkChart *chart, const char *name)
     g_assert_nonnull(chart);
     g_assert_nonnull(name);
 
-    if (chart->font_name != NULL)
+    if (chart->state.font_name != NULL)
     {
-        g_free(chart->font_name);
+        g_free(chart->state.font_name);
     }
 
-    chart->font_name = g_strdup(name);
+    chart->state.font_name = g_strdup(name);
+    chart->state.text_serial++;
 }
 
 EXPORT void gtk_chart_set_slice_value(GtkChart *chart, int index, double value)
@@ -1307,7 +7864,7 @@ EXPORT void gtk_chart_set_slice_value(GtkChart *chart, int index, double value)
   g_assert_nonnull(chart);
   if(index < 0) return;
 
-  GSList *l = chart->slice_list;
+  GSList *l = chart->state.slice_list;
   int i = 0;
 
   while(l != NULL && i < index)
@@ -1328,7 +7885,7 @@ EXPORT bool gtk_chart_set_slice_color(GtkChart *chart, int index, const char *co
   g_assert_nonnull(color);
   if(index < 0) return false;
 
-  GSList *l = chart->slice_list;
+  GSList *l = chart->state.slice_list;
   int i = 0;
 
   while(l != NULL && i < index)
@@ -1349,7 +7906,7 @@ EXPORT void gtk_chart_set_slice_label(GtkChart *chart, int index, const char *la
   g_assert_nonnull(label);
   if(index < 0) return;
 
-  GSList *l = chart->slice_list;
+  GSList *l = chart->state.slice_list;
   int i = 0;
 
   while(l != NULL && i < index)
@@ -1371,7 +7928,7 @@ EXPORT void gtk_chart_set_column_value(GtkChart *chart, int index, double value)
   g_assert_nonnull(chart);
   if(index < 0) return;
 
-  GSList *l = chart->column_list;
+  GSList *l = chart->state.column_list;
   int i = 0;
 
   while(l != NULL && i < index)
@@ -1392,7 +7949,7 @@ EXPORT bool gtk_chart_set_column_color(GtkChart *chart, int index, const char *c
   g_assert_nonnull(color);
   if(index < 0) return false;
 
-  GSList *l = chart->column_list;
+  GSList *l = chart->state.column_list;
   int i = 0;
 
   while(l != NULL && i < index)
@@ -1413,7 +7970,7 @@ EXPORT void gtk_chart_set_column_label(GtkChart *chart, int index, const char *l
   g_assert_nonnull(label);
   if(index < 0) return;
 
-  GSList *l = chart->column_list;
+  GSList *l = chart->state.column_list;
   int i = 0;
 
   while(l != NULL && i < index)
@@ -1434,13 +7991,13 @@ EXPORT void gtk_chart_set_column_ticks(GtkChart *chart, int ticks)
 {
   g_assert_nonnull(chart);
 
-  chart->ticks = ticks;
+  chart->state.ticks = ticks;
 }
 
 EXPORT double gtk_chart_get_column_max_value(GtkChart *chart) {
   double max_value = 0.0;
   GSList *l;
-  for(l = chart->column_list; l != NULL; l = l->next)
+  for(l = chart->state.column_list; l != NULL; l = l->next)
   {
     struct chart_column_t *column = l->data;
     if (column->value > max_value) {
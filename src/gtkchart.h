@@ -50,6 +50,8 @@ G_BEGIN_DECLS
 #define GTK_TYPE_CHART (gtk_chart_get_type ())
 G_DECLARE_FINAL_TYPE (GtkChart, gtk_chart, GTK, CHART, GtkWidget)
 
+typedef struct _GtkChartWriter GtkChartWriter;
+
 typedef enum
 {
   GTK_CHART_TYPE_UNKNOWN,
@@ -62,6 +64,30 @@ typedef enum
   GTK_CHART_TYPE_NUMBER
 } GtkChartType;
 
+typedef enum
+{
+  GTK_CHART_DOWNSAMPLE_NONE,
+  GTK_CHART_DOWNSAMPLE_M4,
+  GTK_CHART_DOWNSAMPLE_LTTB
+} GtkChartDownsample;
+
+typedef enum
+{
+  GTK_CHART_MARKER_CIRCLE,
+  GTK_CHART_MARKER_SQUARE,
+  GTK_CHART_MARKER_DIAMOND,
+  GTK_CHART_MARKER_CROSS,
+  GTK_CHART_MARKER_PLUS
+} GtkChartMarker;
+
+typedef enum
+{
+  GTK_CHART_STORAGE_DOUBLE,
+  GTK_CHART_STORAGE_FLOAT,
+  GTK_CHART_STORAGE_UNIFORM_FLOAT,
+  GTK_CHART_STORAGE_UNIFORM_INT16
+} GtkChartStorage;
+
 EXPORT GtkWidget * gtk_chart_new (void);
 EXPORT void gtk_chart_set_type(GtkChart *chart, GtkChartType type);
 EXPORT void gtk_chart_set_title(GtkChart *chart, const char *title);
@@ -77,7 +103,56 @@ EXPORT double gtk_chart_get_x_min(GtkChart *chart);
 EXPORT double gtk_chart_get_y_max(GtkChart *chart);
 EXPORT double gtk_chart_get_y_min(GtkChart *chart);
 EXPORT void gtk_chart_set_width(GtkChart *chart, int width);
+EXPORT void gtk_chart_set_downsample(GtkChart *chart, GtkChartDownsample mode, unsigned int budget);
+EXPORT GtkChartDownsample gtk_chart_get_downsample(GtkChart *chart);
+EXPORT void gtk_chart_set_max_fps(GtkChart *chart, double fps);
+EXPORT double gtk_chart_get_max_fps(GtkChart *chart);
+EXPORT void gtk_chart_set_strip_chart(GtkChart *chart, bool enable);
+EXPORT bool gtk_chart_get_strip_chart(GtkChart *chart);
+EXPORT void gtk_chart_set_tiled_rendering(GtkChart *chart, bool enable);
+EXPORT bool gtk_chart_get_tiled_rendering(GtkChart *chart);
+EXPORT void gtk_chart_set_marker(GtkChart *chart, GtkChartMarker shape, double size);
+EXPORT GtkChartMarker gtk_chart_get_marker(GtkChart *chart);
+EXPORT double gtk_chart_get_marker_size(GtkChart *chart);
+EXPORT void gtk_chart_set_density(GtkChart *chart, unsigned int cell_size);
+EXPORT unsigned int gtk_chart_get_density(GtkChart *chart);
 EXPORT void gtk_chart_plot_point(GtkChart *chart, double x, double y);
+EXPORT void gtk_chart_plot_points(GtkChart *chart, const double *xs, const double *ys, size_t n);
+EXPORT void gtk_chart_plot_points_strided(GtkChart *chart,
+                                          const double *xs, size_t x_stride,
+                                          const double *ys, size_t y_stride,
+                                          size_t n);
+EXPORT void gtk_chart_plot_points_interleaved(GtkChart *chart, const double *xy, size_t n);
+EXPORT void gtk_chart_set_storage(GtkChart *chart, GtkChartStorage storage);
+EXPORT GtkChartStorage gtk_chart_get_storage(GtkChart *chart);
+EXPORT void gtk_chart_set_uniform_x(GtkChart *chart, double start, double step);
+EXPORT void gtk_chart_set_int16_scale(GtkChart *chart, double offset, double step);
+EXPORT unsigned int gtk_chart_add_series(GtkChart *chart, const char *color);
+EXPORT unsigned int gtk_chart_get_n_series(GtkChart *chart);
+EXPORT void gtk_chart_plot_series_point(GtkChart *chart, double x, const double *ys);
+EXPORT void gtk_chart_plot_series_points(GtkChart *chart, const double *xs, const double * const *ys, size_t n);
+
+// Feed chart from one producer thread, the chart drains queued points once per frame
+EXPORT GtkChartWriter * gtk_chart_writer_new(GtkChart *chart, size_t capacity);
+EXPORT void gtk_chart_writer_free(GtkChartWriter *writer);
+EXPORT bool gtk_chart_writer_push(GtkChartWriter *writer, double x, double y);
+EXPORT bool gtk_chart_writer_push_series(GtkChartWriter *writer, double x, const double *ys);
+EXPORT size_t gtk_chart_writer_get_queued(GtkChartWriter *writer);
+EXPORT guint64 gtk_chart_writer_get_dropped(GtkChartWriter *writer);
+
+EXPORT void gtk_chart_set_capacity(GtkChart *chart, size_t capacity);
+EXPORT size_t gtk_chart_get_capacity(GtkChart *chart);
+EXPORT size_t gtk_chart_get_n_points(GtkChart *chart);
+
+// Series file: 16 byte header of "GCSERIES", version 1 and number of series as little-endian
+// guint32, followed by records sorted by x, each x and one y per series as little-endian doubles
+EXPORT bool gtk_chart_open_series_file(GtkChart *chart, const char *path, GError **error);
+EXPORT void gtk_chart_close_series_file(GtkChart *chart);
+
+EXPORT void gtk_chart_set_history(GtkChart *chart, size_t capacity);
+EXPORT size_t gtk_chart_get_history(GtkChart *chart);
+EXPORT size_t gtk_chart_get_history_n_points(GtkChart *chart);
+EXPORT size_t gtk_chart_get_history_bytes(GtkChart *chart);
 
 EXPORT void gtk_chart_set_value(GtkChart *chart, double value);
 EXPORT void gtk_chart_set_value_min(GtkChart *chart, double value);
@@ -85,8 +160,33 @@ EXPORT void gtk_chart_set_value_max(GtkChart *chart, double value);
 EXPORT double gtk_chart_get_value_min(GtkChart *chart);
 EXPORT double gtk_chart_get_value_max(GtkChart *chart);
 
+EXPORT void gtk_chart_set_csv_format(GtkChart *chart, int precision, char delimiter);
 EXPORT bool gtk_chart_save_csv(GtkChart *chart, const char *filename, GError **error);
+EXPORT bool gtk_chart_write_csv(GtkChart *chart, GOutputStream *stream, GCancellable *cancellable, GError **error);
+EXPORT void gtk_chart_write_csv_async(GtkChart *chart,
+                                      GOutputStream *stream,
+                                      GCancellable *cancellable,
+                                      GFileProgressCallback progress_callback,
+                                      gpointer progress_data,
+                                      GAsyncReadyCallback callback,
+                                      gpointer user_data);
+EXPORT bool gtk_chart_write_csv_finish(GtkChart *chart, GAsyncResult *result, GError **error);
+EXPORT bool gtk_chart_load_csv(GtkChart *chart, const char *filename, GError **error);
+EXPORT void gtk_chart_load_csv_async(GtkChart *chart,
+                                     const char *filename,
+                                     GCancellable *cancellable,
+                                     GAsyncReadyCallback callback,
+                                     gpointer user_data);
+EXPORT bool gtk_chart_load_csv_finish(GtkChart *chart, GAsyncResult *result, GError **error);
+EXPORT bool gtk_chart_save_binary(GtkChart *chart, const char *filename, GError **error);
+EXPORT bool gtk_chart_load_binary(GtkChart *chart, const char *filename, GError **error);
 EXPORT bool gtk_chart_save_png(GtkChart *chart, const char *filename, GError **error);
+EXPORT void gtk_chart_save_png_async(GtkChart *chart,
+                                     const char *filename,
+                                     GCancellable *cancellable,
+                                     GAsyncReadyCallback callback,
+                                     gpointer user_data);
+EXPORT bool gtk_chart_save_png_finish(GtkChart *chart, GAsyncResult *result, GError **error);
 EXPORT GSList * gtk_chart_get_points(GtkChart *chart);
 
 EXPORT void gtk_chart_set_user_data(GtkChart *chart, void *user_data);